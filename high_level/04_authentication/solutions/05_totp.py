@@ -29,14 +29,21 @@ class TOTP(RNG[int]):
     def __init__(self, key: bytes) -> None:
         self._hmac = HMAC(SHA1(), key)
         self._epoch = 0
+        self._counter: int | None = None
+        self._code = 0
 
     def __next__(self) -> int:
-        counter = int((time.time() - self._epoch) / self.PERIOD)
-        mac = self._hmac.compute_code(counter.to_bytes(8))
-        return (int.from_bytes(mac) & 0x7FFFFFFF) % (10**self.DIGITS)
+        # The code only changes once per period, so only recompute it on rollover.
+        counter = max(0, int((time.time() - self._epoch) / self.PERIOD))
+        if counter != self._counter:
+            mac = self._hmac.compute_code(counter.to_bytes(8))
+            self._code = (int.from_bytes(mac) & 0x7FFFFFFF) % (10**self.DIGITS)
+            self._counter = counter
+        return self._code
 
     def set_seed(self, seed: int) -> None:
         self._epoch = seed
+        self._counter = None
 
 
 class Server(BankServer):
@@ -1,17 +1,23 @@
 """Exported symbols."""
 
 from . import _log as log
+from ._async import AsyncActor, AsyncChannel, AsyncMedium
 from ._bio import BiometricSensor
-from ._bytes import blocks, byte_size, generate_bytes, to_bytes, xor
+from ._bytes import Keyspace, blocks, byte_size, generate_bytes, to_bytes, xor
+from ._calibrate import ScryptBenchmark, benchmark_scrypt, calibrate_scrypt, scrypt_profile
 from ._comm import (
     Actor,
     Channel,
+    Clock,
     Message,
     Plaintext,
     Stack,
+    VirtualClock,
 )
 from ._crypto import (
+    AEAD,
     AES256,
+    AES256GCM,
     CBC,
     CTR,
     ECB,
@@ -22,6 +28,7 @@ from ._crypto import (
     BlockCipher,
     BlockCipherMode,
     ChaCha20,
+    ChaCha20Poly1305,
     Cipher,
     Envelope,
     RSAKey,
@@ -32,14 +39,26 @@ from ._crypto import (
     aes256_decrypt_block,
     aes256_encrypt_block,
 )
+from ._files import FileStore
+from ._fuse import Fused
 from ._hash import (
+    ScryptParams,
+    load_scrypt_profile,
     scrypt,
     scrypt_fast,
+    scrypt_params,
+    set_scrypt_params,
     sha1,
     sha256,
 )
+from ._ledger import Account, Ledger, LedgerBenchmark, benchmark_ledger
+from ._load import LatencyHistogram, LoadReport, Operation, OperationStats, generate_load
+from ._mangle import Rule, mangle, mangle_batches
+from ._markov import MarkovModel
 from ._pad import pkcs7_pad, pkcs7_unpad, zero_pad, zero_unpad
 from ._pass import common_passwords, generate_password_database, random_common_password
+from ._passdb import PasswordDatabase
+from ._replay import NonceIssuer, ReplayProtection, ReplayWindow
 from ._rng import (
     HOTP,
     LCG,
@@ -55,11 +74,18 @@ from ._rng import (
     random_string,
 )
 from ._server import BankServer, FileServer, Server
+from ._session import SessionEnvelope
+from ._shm import ProcessActor
+from ._targets import TargetSet, crack_unsalted
+from ._trace import Trace, TraceRecord, TraceRecorder
 from ._util import run_main
 from ._verify import CBCMAC, HMAC, SHA1, SHA256, Hash, Signature, Verifier
+from ._wal import WriteAheadLog
 
 __all__ = [
+    "AEAD",
     "AES256",
+    "AES256GCM",
     "CBC",
     "CBCMAC",
     "CTR",
@@ -75,40 +101,79 @@ __all__ = [
     "TOTP",
     "TRNG",
     "ANSIx917",
+    "Account",
     "Actor",
     "AsymmetricCipher",
     "AsymmetricKey",
+    "AsyncActor",
+    "AsyncChannel",
+    "AsyncMedium",
     "BankServer",
     "BiometricSensor",
     "BlockCipher",
     "BlockCipherMode",
     "ChaCha20",
+    "ChaCha20Poly1305",
     "Channel",
     "Cipher",
     "CipherRNG",
+    "Clock",
     "Envelope",
     "FileServer",
+    "FileStore",
     "Fortuna",
+    "Fused",
     "Hash",
+    "Keyspace",
+    "LatencyHistogram",
+    "Ledger",
+    "LedgerBenchmark",
+    "LoadReport",
+    "MarkovModel",
     "Message",
+    "NonceIssuer",
+    "Operation",
+    "OperationStats",
+    "PasswordDatabase",
     "Plaintext",
+    "ProcessActor",
     "RSAKey",
     "RSAPrivateKey",
     "RSAPublicKey",
+    "ReplayProtection",
+    "ReplayWindow",
+    "Rule",
+    "ScryptBenchmark",
+    "ScryptParams",
     "Server",
+    "SessionEnvelope",
     "Signature",
     "Stack",
     "StreamCipher",
     "SymmetricCipher",
+    "TargetSet",
+    "Trace",
+    "TraceRecord",
+    "TraceRecorder",
     "Verifier",
+    "VirtualClock",
+    "WriteAheadLog",
     "aes256_decrypt_block",
     "aes256_encrypt_block",
+    "benchmark_ledger",
+    "benchmark_scrypt",
     "blocks",
     "byte_size",
+    "calibrate_scrypt",
     "common_passwords",
+    "crack_unsalted",
     "generate_bytes",
+    "generate_load",
     "generate_password_database",
+    "load_scrypt_profile",
     "log",
+    "mangle",
+    "mangle_batches",
     "pkcs7_pad",
     "pkcs7_unpad",
     "random_bytes",
@@ -119,6 +184,9 @@ __all__ = [
     "run_main",
     "scrypt",
     "scrypt_fast",
+    "scrypt_params",
+    "scrypt_profile",
+    "set_scrypt_params",
     "sha1",
     "sha256",
     "to_bytes",
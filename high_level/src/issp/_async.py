@@ -0,0 +1,446 @@
+from __future__ import annotations
+
+import asyncio
+import inspect
+import itertools
+import threading
+from typing import TYPE_CHECKING
+
+from . import _log as log
+from ._comm import Actor, Channel, Clock, Event, EventQueue, Medium, Message, Stack
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Coroutine
+    from typing import Any
+
+    from ._comm import Layer
+
+
+class AsyncEvent(Event):
+    """An event awaited by a coroutine rather than by a thread."""
+
+    def __init__(self, priority: int, token: str | None = None) -> None:
+        super().__init__(priority, token)
+        self._future: asyncio.Future[None] = asyncio.get_running_loop().create_future()
+
+    def set(self) -> None:
+        if not self._future.done():
+            self._future.set_result(None)
+
+    async def wait_async(self, timeout: float | None = None) -> None:
+        """
+        Wait until the event is set.
+
+        :param timeout: The maximum time to wait, in seconds.
+        """
+        try:
+            await asyncio.wait_for(asyncio.shield(self._future), timeout)
+        except TimeoutError:
+            err_msg = f"Timed out after {timeout:g} seconds"
+            raise TimeoutError(err_msg) from None
+
+
+class AsyncMedium:
+    """
+    Communication medium for coroutine actors.
+
+    .. note::
+        This is the asyncio counterpart of the medium used by `Actor.start`, with the same tick
+        phases, priorities and recipient tokens. Waiting actors are futures rather than blocked
+        threads, so a single event loop can serve thousands of them.
+    """
+
+    @property
+    def interval(self) -> float:
+        return self._interval
+
+    def __init__(self, interval: float = 1.0) -> None:
+        self._msg: Message = Message.empty()
+        self._interval = interval
+        self._write_queue = EventQueue("Write")
+        self._read_queue = EventQueue("Read")
+        self._ticks = 0
+        self._tick_futures: dict[int, asyncio.Future[None]] = {}
+        self._subscribers: list[tuple[Callable[[Message], bool], asyncio.Future[Message]]] = []
+        self._ticker: asyncio.Task[None] | None = None
+
+    def start(self) -> None:
+        """Start ticking on the running event loop."""
+        if self._ticker is None:
+            self._ticker = asyncio.get_running_loop().create_task(self._tick())
+
+    def stop(self) -> None:
+        """Stop ticking."""
+        if self._ticker is not None:
+            self._ticker.cancel()
+            self._ticker = None
+
+    async def _tick(self) -> None:
+        for i in itertools.count(start=1):
+            await asyncio.sleep(self._interval)
+            log.debug("[Medium] Tick %d", i)
+            if len(self._write_queue) and self._read_queue.token is None:
+                self._write_queue.dequeue()
+                await asyncio.sleep(self._interval)
+            if not self._msg.is_empty:
+                self._read_queue.dequeue()
+            self._ticks = i
+            if (future := self._tick_futures.pop(i, None)) is not None:
+                future.set_result(None)
+
+    async def _enqueue(
+        self,
+        queue: EventQueue,
+        priority: int = 0,
+        token: str | None = None,
+        timeout: float | None = None,
+    ) -> None:
+        event = AsyncEvent(priority, token)
+        queue.push(event)
+        await event.wait_async(timeout)
+
+    def _set_msg(self, msg: Message) -> None:
+        self._msg = msg
+        pending: list[tuple[Callable[[Message], bool], asyncio.Future[Message]]] = []
+        for predicate, future in self._subscribers:
+            if future.done():
+                continue
+            if predicate(msg):
+                future.set_result(msg)
+            else:
+                pending.append((predicate, future))
+        self._subscribers = pending
+
+    def peek(self) -> Message:
+        return self._msg.copy()
+
+    async def subscribe(
+        self,
+        predicate: Callable[[Message], bool],
+        *,
+        timeout: float | None = None,
+    ) -> Message:
+        """
+        Wait until the message on the medium satisfies a predicate.
+
+        :param predicate: The predicate.
+        :param timeout: The maximum time to wait, in seconds.
+        :return: A copy of the message that satisfied the predicate.
+        """
+        if predicate(self._msg):
+            return self._msg.copy()
+        future: asyncio.Future[Message] = asyncio.get_running_loop().create_future()
+        self._subscribers.append((predicate, future))
+        try:
+            msg = await asyncio.wait_for(future, timeout)
+        except TimeoutError:
+            err_msg = f"Timed out after {timeout:g} seconds"
+            raise TimeoutError(err_msg) from None
+        return msg.copy()
+
+    async def read(
+        self,
+        recipient: str | None,
+        priority: int,
+        *,
+        timeout: float | None = None,
+        clear: bool = True,
+    ) -> Message:
+        await self._enqueue(self._read_queue, priority, recipient, timeout)
+        if clear:
+            msg = self._msg
+            self._set_msg(Message.empty())
+        else:
+            msg = self._msg.copy()
+        return msg
+
+    async def write(self, msg: Message, priority: int, *, timeout: float | None = None) -> None:
+        await self._enqueue(self._write_queue, priority, timeout=timeout)
+        self._read_queue.token = msg.recipient
+        self._set_msg(msg.copy())
+
+    async def wait(self, turns: int = 1) -> None:
+        # Actors waiting for the same tick share a single future, and are only woken up once.
+        if turns <= 0:
+            return
+        tick = self._ticks + turns
+        if (future := self._tick_futures.get(tick)) is None:
+            future = asyncio.get_running_loop().create_future()
+            self._tick_futures[tick] = future
+        await asyncio.shield(future)
+
+
+class AsyncChannel:
+    """A communication channel for coroutine actors, with the same interface as `Channel`."""
+
+    @property
+    def stack(self) -> Stack:
+        """The security stack applied to messages sent and received through this channel."""
+        return self._stack
+
+    def __init__(
+        self,
+        name: str,
+        medium: AsyncMedium,
+        stack: Layer,
+        priority: int = 0,
+    ) -> None:
+        self._stack = Stack(stack)
+        self._medium = medium
+        self._name = name
+        self._priority = priority
+
+    def _get_priority(self, override: int | None) -> int:
+        return self._priority if override is None else override
+
+    async def send(
+        self,
+        msg: Message,
+        *,
+        priority: int | None = None,
+        timeout: float | None = None,
+        quiet: bool = False,
+    ) -> None:
+        """
+        Send a message through the communication medium.
+
+        :param msg: The message to be sent.
+        :param priority: The priority level for writing to the medium.
+                         If None, an instance-specific default priority is used.
+        :param timeout: The maximum time to wait for a message, in seconds.
+        """
+        try:
+            enc_msg = self.stack.encode(msg.copy())
+            await self._medium.write(enc_msg, self._get_priority(priority), timeout=timeout)
+        except Exception as e:
+            self._log_exception(e)
+        else:
+            if not quiet:
+                self._log_msg("Sent", msg)
+
+    async def receive(
+        self,
+        recipient: str | None = None,
+        *,
+        priority: int | None = None,
+        timeout: float | None = None,
+        quiet: bool = False,
+    ) -> Message:
+        """
+        Receive a message from the communication medium.
+
+        :param recipient: The intended recipient of the message.
+                          If None, any message can be received.
+        :param priority: The priority level for reading from the medium.
+                         If None, an instance-specific default priority is used.
+        :param timeout: The maximum time to wait for a message, in seconds.
+        :return: The received message.
+        """
+        try:
+            priority = self._get_priority(priority)
+            msg = await self._medium.read(recipient, priority, timeout=timeout)
+            msg = self.stack.decode(msg)
+        except Exception as e:
+            self._log_exception(e)
+            msg = Message.empty()
+        else:
+            if not quiet:
+                self._log_msg("Received", msg)
+        return msg
+
+    async def peek(
+        self,
+        *,
+        priority: int | None = None,
+        timeout: float | None = None,
+        quiet: bool = False,
+    ) -> Message:
+        """
+        Peek at a message in the communication medium without removing it.
+
+        :param priority: The priority level for reading from the medium.
+                         If None, an instance-specific default priority is used.
+        :param timeout: The maximum time to wait for a message, in seconds.
+        :return: The peeked message.
+        """
+        try:
+            priority = self._get_priority(priority)
+            msg = await self._medium.read(Event.PEEK_TOKEN, priority, clear=False, timeout=timeout)
+            msg = self.stack.decode(msg)
+        except Exception as e:
+            self._log_exception(e)
+            msg = Message.empty()
+        else:
+            if not quiet:
+                self._log_msg("Peeked", msg)
+        return msg
+
+    async def request(
+        self,
+        msg: Message,
+        *,
+        priority: int | None = None,
+        timeout: float | None = None,
+        quiet: bool = False,
+    ) -> Message:
+        """
+        Send a message and wait for a response.
+
+        :param msg: The message to be sent.
+        :param priority: The priority level for writing to and reading from the medium.
+                         If None, an instance-specific default priority is used.
+        :param timeout: The maximum time to wait for a response, in seconds.
+        :return: The received response message.
+        """
+        await self.send(msg, priority=priority, timeout=timeout, quiet=quiet)
+        return await self.receive(msg.sender, priority=priority, timeout=timeout, quiet=quiet)
+
+    async def wait(self, ticks: int = 1) -> None:
+        """
+        Wait for a specified number of ticks (time intervals) on the communication medium.
+
+        :param ticks: The number of ticks to wait.
+        """
+        await self._medium.wait(ticks)
+
+    async def wait_for(self, sender: str) -> None:
+        """
+        Wait until a message from the specified sender is available on the communication medium.
+
+        :param sender: The sender whose message to wait for.
+        """
+        await self._medium.subscribe(lambda msg: msg.sender == sender)
+
+    def with_stack(self, stack: Layer) -> AsyncChannel:
+        """
+        Create a new channel over the same medium but with a different security stack.
+
+        :param stack: The new security stack.
+        :return: New channel instance.
+        """
+        return AsyncChannel(self._name, self._medium, stack, self._priority)
+
+    def _log_msg(self, prefix: str, msg: Message) -> None:
+        log.info("[%s] %s: %s", self._name, prefix, msg)
+
+    def _log_exception(self, e: Exception) -> None:
+        log.warning("[%s] %s", self._name, e)
+
+
+class _BlockingMedium(Medium):
+    # Lets synchronous actors use an `AsyncMedium` through a regular `Channel`, by running
+    # each operation on the event loop and blocking the actor's thread until it completes.
+
+    def __init__(self, medium: AsyncMedium, loop: asyncio.AbstractEventLoop) -> None:
+        self._medium = medium
+        self._loop = loop
+        self._clock = Clock()
+
+    @property
+    def interval(self) -> float:
+        return self._medium.interval
+
+    def _call[T](self, coro: Coroutine[Any, Any, T]) -> T:
+        return asyncio.run_coroutine_threadsafe(coro, self._loop).result()
+
+    def peek(self) -> Message:
+        return self._medium.peek()
+
+    def subscribe(
+        self,
+        predicate: Callable[[Message], bool],
+        *,
+        timeout: float | None = None,
+    ) -> Message:
+        return self._call(self._medium.subscribe(predicate, timeout=timeout))
+
+    def read(
+        self,
+        recipient: str | None,
+        priority: int,
+        *,
+        timeout: float | None = None,
+        clear: bool = True,
+    ) -> Message:
+        return self._call(self._medium.read(recipient, priority, timeout=timeout, clear=clear))
+
+    def write(self, msg: Message, priority: int, *, timeout: float | None = None) -> None:
+        self._call(self._medium.write(msg, priority, timeout=timeout))
+
+    def wait(self, turns: int = 1) -> None:
+        self._call(self._medium.wait(turns))
+
+
+class AsyncActor(Actor):
+    """
+    An actor run on an asyncio event loop.
+
+    The target can be a coroutine function, which receives `AsyncChannel` instances, or a regular
+    function, which receives `Channel` instances and runs in its own thread, so that existing
+    actors and servers can share the medium with coroutine actors.
+    """
+
+    @staticmethod
+    async def run(*args: Actor, interval: float = 1.0) -> None:
+        """
+        Run actors on a shared medium until all of them return.
+
+        :param args: The actors, either `AsyncActor` or `Actor` instances.
+        :param interval: Duration of a tick of the medium, in seconds.
+        """
+        loop = asyncio.get_running_loop()
+        medium = AsyncMedium(interval=interval)
+        blocking = _BlockingMedium(medium, loop)
+        medium.start()
+        try:
+            tasks = []
+            for a in args:
+                if inspect.iscoroutinefunction(a.target):
+                    channels: tuple[Any, ...] = tuple(
+                        AsyncChannel(a.name, medium, s, a.priority) for s in a.stacks
+                    )
+                    tasks.append(a.target(*channels, *a.data))
+                else:
+                    channels = tuple(Channel(a.name, blocking, s, a.priority) for s in a.stacks)
+                    tasks.append(_run_in_thread(loop, a.target, *channels, *a.data))
+            results = await asyncio.gather(*tasks, return_exceptions=True)
+        finally:
+            medium.stop()
+        for a, result in zip(args, results, strict=True):
+            if isinstance(result, Exception):
+                log.error("[%s] %s: %s", a.name, type(result).__name__, result)
+
+    @staticmethod
+    def start(*args: Actor, interval: float = 1.0, virtual: bool | None = None) -> None:
+        """
+        Run actors on a new event loop until all of them return.
+
+        :param args: The actors, either `AsyncActor` or `Actor` instances.
+        :param interval: Duration of a tick of the medium, in seconds.
+        :param virtual: Must be None or False, since virtual time is not supported.
+        """
+        if virtual:
+            err_msg = "Virtual time is not supported by asynchronous actors"
+            raise ValueError(err_msg)
+        asyncio.run(AsyncActor.run(*args, interval=interval))
+
+
+async def _run_in_thread(
+    loop: asyncio.AbstractEventLoop,
+    target: Callable[..., None],
+    *args: object,
+) -> None:
+    # A dedicated thread rather than the default executor, whose workers could all end up
+    # blocked on the medium.
+    done: asyncio.Future[None] = loop.create_future()
+
+    def run() -> None:
+        try:
+            target(*args)
+        except Exception as e:
+            loop.call_soon_threadsafe(done.set_exception, e)
+        else:
+            loop.call_soon_threadsafe(done.set_result, None)
+
+    threading.Thread(target=run, daemon=True).start()
+    await done
@@ -1,6 +1,14 @@
+from __future__ import annotations
+
+import bisect
 import itertools
+import json
 import sys
-from collections.abc import Iterable, Iterator, Sequence
+from pathlib import Path
+from typing import TYPE_CHECKING
+
+if TYPE_CHECKING:
+    from collections.abc import Iterable, Iterator, Sequence
 
 
 def xor(a: Iterable[int], b: Iterable[int]) -> bytes:
@@ -72,6 +80,203 @@ def split(data: bytes, sizes: int | Sequence[int]) -> Sequence[bytes]:
     return parts
 
 
+def _charset_bytes(charset: Iterable[int] | str | None) -> bytes:
+    if charset is None:
+        return bytes(range(256))
+    if isinstance(charset, str):
+        return charset.encode()
+    return bytes(charset)
+
+
+class Keyspace:
+    """
+    The space of all byte sequences of given lengths over a character set.
+
+    .. note::
+        Candidates are numbered in the same order as `generate_bytes`: by length, in the order
+        the lengths are given, then lexicographically by charset position. Each candidate maps
+        to its index and back in mixed radix, so a keyspace can be split into shards and
+        iteration can resume from any index.
+    """
+
+    BATCH_SIZE = 2**16
+
+    @property
+    def lengths(self) -> Sequence[int]:
+        """Lengths of the candidates."""
+        return self._lengths
+
+    @property
+    def charset(self) -> bytes:
+        """Symbols the candidates are built from."""
+        return self._charset
+
+    @property
+    def size(self) -> int:
+        """Total number of candidates across all lengths, regardless of the index range."""
+        return self._offsets[-1]
+
+    def __init__(
+        self,
+        length: int | Iterable[int],
+        charset: Iterable[int] | str | None = None,
+        start: int = 0,
+        stop: int | None = None,
+    ) -> None:
+        """
+        Initialize the keyspace.
+
+        :param length: Length or lengths of the candidates.
+        :param charset: Character set to use. If None, all 256 byte values are used.
+                        If a string is provided, its UTF-8 byte values are used.
+        :param start: Index of the first candidate in this keyspace.
+        :param stop: Index past the last candidate in this keyspace. If None, the keyspace
+                     extends to the last candidate.
+        """
+        self._lengths = (length,) if isinstance(length, int) else tuple(length)
+        if any(l < 0 for l in self._lengths):
+            err_msg = "Lengths must be non-negative."
+            raise ValueError(err_msg)
+        self._charset = _charset_bytes(charset)
+        self._symbols = {c: i for i, c in reversed(list(enumerate(self._charset)))}
+        radix = len(self._charset)
+        self._offsets = tuple(itertools.accumulate((radix**l for l in self._lengths), initial=0))
+        self._suffixes: dict[int, list[bytes]] = {}
+        self.start = max(0, min(start, self.size))
+        """Index of the first candidate."""
+        self.stop = self.size if stop is None else max(self.start, min(stop, self.size))
+        """Index past the last candidate."""
+        self.position = self.start
+        """Index of the next candidate to be produced by iteration."""
+
+    def __repr__(self) -> str:
+        return (
+            f"Keyspace(lengths={self._lengths}, charset={self._charset!r}, "
+            f"start={self.start}, stop={self.stop}, position={self.position})"
+        )
+
+    def __len__(self) -> int:
+        return self.stop - self.start
+
+    def __getitem__(self, index: int) -> bytes:
+        return self.candidate(index)
+
+    def candidate(self, index: int) -> bytes:
+        """
+        Return the candidate at the given index.
+
+        :param index: Index of the candidate, between 0 and `size`.
+        :return: The candidate.
+        """
+        if not 0 <= index < self.size:
+            err_msg = f"Index {index} out of range."
+            raise IndexError(err_msg)
+        segment = bisect.bisect_right(self._offsets, index) - 1
+        return self._digits(index - self._offsets[segment], self._lengths[segment])
+
+    def index(self, candidate: bytes) -> int:
+        """
+        Return the index of the given candidate.
+
+        :param candidate: The candidate.
+        :return: Index of the candidate.
+        """
+        try:
+            segment = self._lengths.index(len(candidate))
+            value = 0
+            for c in candidate:
+                value = value * len(self._charset) + self._symbols[c]
+        except (KeyError, ValueError):
+            err_msg = f"{candidate!r} is not in the keyspace."
+            raise ValueError(err_msg) from None
+        return self._offsets[segment] + value
+
+    def shard(self, k: int, n: int) -> Keyspace:
+        """
+        Return the k-th of n contiguous, non-overlapping shards of this keyspace.
+
+        :param k: Index of the shard, between 0 and n - 1.
+        :param n: Number of shards.
+        :return: The shard.
+        """
+        if not 0 <= k < n:
+            err_msg = f"Shard {k} out of range for {n} shards."
+            raise ValueError(err_msg)
+        start = self.start + len(self) * k // n
+        stop = self.start + len(self) * (k + 1) // n
+        return Keyspace(self._lengths, self._charset, start, stop)
+
+    def checkpoint(self, path: str | Path) -> None:
+        """
+        Atomically save the keyspace and its current position to a file.
+
+        Resuming from a checkpoint never skips candidates, but it may repeat the last batch
+        that was being consumed when the checkpoint was taken.
+
+        :param path: Path of the checkpoint file.
+        """
+        path = Path(path)
+        state = {
+            "lengths": self._lengths,
+            "charset": self._charset.hex(),
+            "start": self.start,
+            "stop": self.stop,
+            "position": self.position,
+        }
+        tmp = path.with_name(f"{path.name}.tmp")
+        tmp.write_text(json.dumps(state))
+        tmp.replace(path)
+
+    @classmethod
+    def restore(cls, path: str | Path) -> Keyspace:
+        """
+        Load a keyspace saved by `checkpoint`.
+
+        :param path: Path of the checkpoint file.
+        :return: The keyspace, positioned where the checkpoint was taken.
+        """
+        state = json.loads(Path(path).read_text())
+        ks = cls(state["lengths"], bytes.fromhex(state["charset"]), state["start"], state["stop"])
+        ks.position = max(ks.start, min(state["position"], ks.stop))
+        return ks
+
+    def __iter__(self) -> Iterator[bytes]:
+        while self.position < self.stop:
+            count, batch = self._batch(self.position)
+            yield from batch
+            self.position += count
+
+    def _digits(self, value: int, length: int) -> bytes:
+        radix = len(self._charset)
+        out = bytearray(length)
+        for i in range(length - 1, -1, -1):
+            value, digit = divmod(value, radix)
+            out[i] = self._charset[digit]
+        return bytes(out)
+
+    def _suffix_table(self, length: int) -> list[bytes]:
+        if (table := self._suffixes.get(length)) is None:
+            table = [bytes(k) for k in itertools.product(self._charset, repeat=length)]
+            self._suffixes[length] = table
+        return table
+
+    def _batch(self, index: int) -> tuple[int, Iterator[bytes]]:
+        # The last positions of a candidate vary fastest: they are taken from a precomputed table
+        # of suffixes, which is concatenated to the prefix shared by the whole batch.
+        segment = bisect.bisect_right(self._offsets, index) - 1
+        length = self._lengths[segment]
+        value = index - self._offsets[segment]
+        radix = len(self._charset)
+        suffix_length = 0
+        while suffix_length < length and radix ** (suffix_length + 1) <= self.BATCH_SIZE:
+            suffix_length += 1
+        prefix_value, first = divmod(value, radix**suffix_length)
+        last = min(radix**suffix_length, first + self.stop - index)
+        prefix = self._digits(prefix_value, length - suffix_length)
+        suffixes = itertools.islice(self._suffix_table(suffix_length), first, last)
+        return last - first, map(prefix.__add__, suffixes)
+
+
 def generate_bytes(
     length: int | Iterable[int] = 0,
     charset: Iterable[int] | str | None = None,
@@ -87,8 +292,6 @@ def generate_bytes(
     """
     if isinstance(length, int):
         length = (length,) if length else itertools.count(1)
-    if charset is None:
-        charset = range(256)
-    elif isinstance(charset, str):
-        charset = charset.encode()
-    yield from (bytes(k) for l in length for k in itertools.product(charset, repeat=l))
+    charset = _charset_bytes(charset)
+    for l in length:
+        yield from Keyspace(l, charset)
@@ -0,0 +1,191 @@
+from __future__ import annotations
+
+import argparse
+import json
+import os
+import platform
+import statistics
+import time
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+from typing import TYPE_CHECKING, Any, NamedTuple
+
+from cryptography.hazmat.primitives.kdf.scrypt import Scrypt
+
+from . import _log as log
+from ._hash import ScryptParams
+
+if TYPE_CHECKING:
+    from collections.abc import Iterable, Sequence
+
+
+class ScryptBenchmark(NamedTuple):
+    """Performance of scrypt with given parameters on the current machine."""
+
+    params: ScryptParams
+    """The benchmarked parameters."""
+    latency: float
+    """Median time of a single derivation, in seconds."""
+    throughput: float
+    """Derivations per second with all workers busy."""
+    workers: int
+    """Number of worker processes used to measure throughput."""
+
+    @property
+    def memory(self) -> int:
+        """Memory required by a single derivation, in bytes."""
+        return self.params.memory
+
+
+def _derive(params: ScryptParams) -> None:
+    Scrypt(salt=b"calibration", length=32, n=params.n, r=params.r, p=params.p).derive(b"password")
+
+
+def benchmark_scrypt(
+    params: ScryptParams,
+    samples: int = 5,
+    workers: int | None = None,
+    executor: ProcessPoolExecutor | None = None,
+) -> ScryptBenchmark:
+    """
+    Measure the latency and parallel throughput of scrypt.
+
+    :param params: The parameters to benchmark.
+    :param samples: Number of derivations timed for latency, and per worker for throughput.
+    :param workers: Number of worker processes. If None, uses the number of CPUs.
+    :param executor: Process pool to reuse across benchmarks. If None, a new one is created.
+    :return: The benchmark results.
+    """
+    workers = workers or os.cpu_count() or 1
+    timings: list[float] = []
+    for _ in range(max(1, samples)):
+        start = time.perf_counter()
+        _derive(params)
+        timings.append(time.perf_counter() - start)
+
+    pool = executor or ProcessPoolExecutor(workers)
+    try:
+        list(pool.map(_derive, [params] * workers))  # Warm up the workers.
+        count = workers * max(1, samples)
+        start = time.perf_counter()
+        list(pool.map(_derive, [params] * count))
+        throughput = count / (time.perf_counter() - start)
+    finally:
+        if executor is None:
+            pool.shutdown()
+
+    return ScryptBenchmark(params, statistics.median(timings), throughput, workers)
+
+
+def calibrate_scrypt(
+    target_latency: float = 0.1,
+    capacity: float | None = None,
+    r_values: Iterable[int] = (8,),
+    p_values: Iterable[int] = (1,),
+    max_memory: int = 2**30,
+    samples: int = 3,
+    workers: int | None = None,
+) -> tuple[ScryptBenchmark | None, list[ScryptBenchmark]]:
+    """
+    Find the most expensive scrypt parameters meeting latency and capacity targets.
+
+    For each (r, p) pair, n is doubled starting from 2**10 until the latency target
+    or the memory limit is exceeded.
+
+    :param target_latency: Maximum time of a single verification, in seconds.
+    :param capacity: Minimum number of verifications per second. If None, it is not enforced.
+    :param r_values: Block sizes to try.
+    :param p_values: Parallelization factors to try.
+    :param max_memory: Maximum memory per derivation, in bytes.
+    :param samples: Number of timed derivations per measurement.
+    :param workers: Number of worker processes. If None, uses the number of CPUs.
+    :return: The recommended benchmark, if any meets the targets, and all benchmarks.
+    """
+    workers = workers or os.cpu_count() or 1
+    results: list[ScryptBenchmark] = []
+    with ProcessPoolExecutor(workers) as executor:
+        for r in r_values:
+            for p in p_values:
+                n = 2**10
+                while (params := ScryptParams(n, r, p)).memory <= max_memory:
+                    result = benchmark_scrypt(params, samples, workers, executor)
+                    log.info("[Calibrate] %s", _describe(result))
+                    results.append(result)
+                    if result.latency > target_latency:
+                        break
+                    n *= 2
+
+    def acceptable(b: ScryptBenchmark) -> bool:
+        return b.latency <= target_latency and (capacity is None or b.throughput >= capacity)
+
+    best = max(filter(acceptable, results), key=lambda b: (b.memory, b.latency), default=None)
+    return best, results
+
+
+def scrypt_profile(benchmark: ScryptBenchmark) -> dict[str, Any]:
+    """
+    Build a JSON-serializable profile that can be loaded by `load_scrypt_profile`.
+
+    :param benchmark: The benchmark of the recommended parameters.
+    :return: The profile.
+    """
+    return {
+        "n": benchmark.params.n,
+        "r": benchmark.params.r,
+        "p": benchmark.params.p,
+        "latency": benchmark.latency,
+        "throughput": benchmark.throughput,
+        "memory": benchmark.memory,
+        "workers": benchmark.workers,
+        "host": platform.node(),
+        "machine": platform.machine(),
+    }
+
+
+def _describe(b: ScryptBenchmark) -> str:
+    n, r, p = b.params
+    return (
+        f"n=2**{n.bit_length() - 1} r={r} p={p}: {b.latency * 1000:.1f} ms, "
+        f"{b.throughput:.1f}/s on {b.workers} workers, {b.memory / 2**20:.0f} MiB"
+    )
+
+
+def main(argv: Sequence[str] | None = None) -> None:
+    parser = argparse.ArgumentParser(
+        prog="python -m issp._calibrate",
+        description="Benchmark scrypt on this machine and recommend cost parameters.",
+    )
+    parser.add_argument("-l", "--latency", type=float, default=0.1, help="target latency (s)")
+    parser.add_argument("-c", "--capacity", type=float, help="minimum verifications per second")
+    parser.add_argument("-r", type=int, nargs="+", default=[8], help="block sizes to try")
+    parser.add_argument("-p", type=int, nargs="+", default=[1], help="parallelization factors")
+    parser.add_argument("-m", "--max-memory", type=int, default=1024, help="memory limit (MiB)")
+    parser.add_argument("-s", "--samples", type=int, default=3, help="timed runs per setting")
+    parser.add_argument("-w", "--workers", type=int, help="worker processes (default: CPUs)")
+    parser.add_argument("-o", "--output", type=Path, help="write the JSON profile to this file")
+    args = parser.parse_args(argv)
+
+    best, _ = calibrate_scrypt(
+        target_latency=args.latency,
+        capacity=args.capacity,
+        r_values=args.r,
+        p_values=args.p,
+        max_memory=args.max_memory * 2**20,
+        samples=args.samples,
+        workers=args.workers,
+    )
+    if best is None:
+        log.error("[Calibrate] No parameters meet the given targets.")
+        raise SystemExit(1)
+
+    log.info("[Calibrate] Recommended: %s", _describe(best))
+    profile = json.dumps(scrypt_profile(best), indent=2)
+    if args.output:
+        args.output.write_text(profile + "\n")
+        log.info("[Calibrate] Profile written to %s", args.output)
+    else:
+        print(profile)
+
+
+if __name__ == "__main__":
+    main()
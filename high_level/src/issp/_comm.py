@@ -1,18 +1,25 @@
 from __future__ import annotations
 
 import base64
+import contextlib
+import heapq
 import itertools
 import json
+import os
 import threading
 import time
-from typing import TYPE_CHECKING
+from typing import TYPE_CHECKING, ClassVar
 
 from . import _log as log
 
 if TYPE_CHECKING:
-    from collections.abc import Callable, Sequence
+    from collections.abc import Callable, Iterator, Sequence
     from typing import Any
 
+    from ._trace import TraceRecorder
+
+    type FusionRule = Callable[[Sequence[Layer]], tuple[Layer, int] | None]
+
 
 type JSONDictBody = dict[str, Any]
 type JSONListBody = list[Any]
@@ -21,6 +28,9 @@ type JSONBody = JSONStructBody | str
 type RawBody = bytes | str
 type Body = RawBody | JSONBody
 
+VIRTUAL_TIME_ENV = "ISSP_VIRTUAL_TIME"
+"""Environment variable that, if set to 1, makes `Actor.start` use virtual time by default."""
+
 
 class Message:
     """A message exchanged between entities over a communication channel."""
@@ -298,9 +308,7 @@ class Channel:
 
         :param sender: The sender whose message to wait for.
         """
-        interval = self._medium.interval * 0.5
-        while self._medium.peek().sender != sender:
-            time.sleep(interval)
+        self._medium.subscribe(lambda msg: msg.sender == sender)
 
     def with_stack(self, stack: Layer) -> Channel:
         """
@@ -357,18 +365,43 @@ class Plaintext(Layer):
 
 
 class Stack(Layer):
-    """A stack of security layers that can be applied to messages for encoding and decoding."""
+    """
+    A stack of security layers that can be applied to messages for encoding and decoding.
+
+    .. note::
+        When the stack is built, sequences of layers matching a registered fusion rule are
+        replaced by equivalent, faster implementations that produce the same bytes, e.g. native
+        AES modes or a single pass for encrypt-then-MAC. The original layers are still exposed
+        by `layers`, and are used by the fused implementations, so changing their keys
+        after building the stack has the expected effect.
+    """
+
+    _fusion_rules: ClassVar[list[FusionRule]] = []
+
+    @classmethod
+    def add_fusion_rule(cls, rule: FusionRule) -> None:
+        """
+        Register a rule that replaces sequences of layers with an equivalent layer.
+
+        Rules are tried in registration order at each position of the stack.
+
+        :param rule: Function that receives the layers from a given position onward, and returns
+                     the replacement layer and the number of layers it replaces, or None if
+                     it does not apply.
+        """
+        cls._fusion_rules.append(rule)
 
     @property
     def layers(self) -> Sequence[Layer]:
         """The list of layers in the stack."""
         return (*self._layers,)
 
-    def __init__(self, *layers: Layer) -> None:
+    def __init__(self, *layers: Layer, optimize: bool = True) -> None:
         """
         Initialize a stack of security layers.
 
         :param layers: The layers to be included in the stack.
+        :param optimize: Whether to apply the registered fusion rules.
         """
         self._layers: list[Layer] = []
         for layer in layers:
@@ -376,6 +409,21 @@ class Stack(Layer):
                 self._layers.extend(layer.layers)
             elif not isinstance(layer, Plaintext):
                 self._layers.append(layer)
+        self._pipeline = self._fuse(self._layers) if optimize else self._layers
+
+    @classmethod
+    def _fuse(cls, layers: Sequence[Layer]) -> list[Layer]:
+        pipeline: list[Layer] = []
+        i = 0
+        while i < len(layers):
+            layer, count = layers[i], 1
+            for rule in cls._fusion_rules:
+                if (match := rule(layers[i:])) is not None:
+                    layer, count = match
+                    break
+            pipeline.append(layer)
+            i += count
+        return pipeline
 
     def __len__(self) -> int:
         return len(self._layers)
@@ -390,7 +438,7 @@ class Stack(Layer):
         :param msg: The message to be encoded.
         :return: The encoded message.
         """
-        for layer in self._layers:
+        for layer in self._pipeline:
             msg = layer.encode(msg)
         return msg
 
@@ -401,21 +449,38 @@ class Stack(Layer):
         :param msg: The message to be decoded.
         :return: The decoded message.
         """
-        for layer in reversed(self._layers):
+        for layer in reversed(self._pipeline):
             msg = layer.decode(msg)
         return msg
 
 
 class Actor:
     @staticmethod
-    def start(*args: Actor, interval: float = 1.0) -> None:
-        medium = Medium(interval=interval)
+    def start(
+        *args: Actor,
+        interval: float = 1.0,
+        virtual: bool | None = None,
+        recorder: TraceRecorder | None = None,
+    ) -> None:
+        """
+        Run actors on a shared medium until all of them return.
+
+        :param args: The actors.
+        :param interval: Duration of a tick of the medium, in seconds.
+        :param virtual: Whether to run on a `VirtualClock` rather than on the wall clock.
+                        If None, virtual time is used if the `ISSP_VIRTUAL_TIME` environment
+                        variable is set to 1.
+        :param recorder: If set, messages written to the medium are recorded to its trace.
+        """
+        if virtual is None:
+            virtual = os.environ.get(VIRTUAL_TIME_ENV) == "1"
+        clock = VirtualClock() if virtual else Clock()
         threads: list[threading.Thread] = []
-        for a in args:
-            channels = tuple(Channel(a.name, medium, s, a.priority) for s in a.stacks)
-            thread = threading.Thread(target=a.target, args=(*channels, *a.data), daemon=True)
-            threads.append(thread)
-            thread.start()
+        with clock.hold():
+            medium = Medium(interval=interval, clock=clock, recorder=recorder)
+            for a in args:
+                channels = tuple(Channel(a.name, medium, s, a.priority) for s in a.stacks)
+                threads.append(clock.start_thread(a.target, (*channels, *a.data)))
         for t in threads:
             t.join()
 
@@ -434,29 +499,212 @@ class Actor:
         self.data = () if data is None else data
 
 
+class Clock:
+    """Wall clock, used by the medium to schedule ticks and by actors to wait for events."""
+
+    def time(self) -> float:
+        """
+        Return the current time.
+
+        :return: The current time, in seconds.
+        """
+        return time.monotonic()
+
+    def sleep(self, seconds: float) -> None:
+        """
+        Block the calling thread.
+
+        :param seconds: Time to sleep, in seconds.
+        """
+        time.sleep(seconds)
+
+    def wait(self, event: Event, timeout: float | None = None) -> bool:
+        """
+        Block the calling thread until an event is set.
+
+        :param event: The event.
+        :param timeout: The maximum time to wait, in seconds.
+        :return: True if the event was set, False if the wait timed out.
+        """
+        return event.flag.wait(timeout)
+
+    def set(self, event: Event) -> None:
+        """
+        Set an event, waking up the thread waiting for it.
+
+        :param event: The event.
+        """
+        event.flag.set()
+
+    def start_thread(
+        self,
+        target: Callable[..., None],
+        args: Sequence[Any] = (),
+        *,
+        service: bool = False,
+    ) -> threading.Thread:
+        """
+        Start a daemon thread whose waits are scheduled by this clock.
+
+        :param target: The function run by the thread.
+        :param args: The arguments of the function.
+        :param service: Whether the thread runs for as long as the program, e.g. a ticker.
+        :return: The started thread.
+        """
+        del service  # Unused
+        thread = threading.Thread(target=target, args=args, daemon=True)
+        thread.start()
+        return thread
+
+    @contextlib.contextmanager
+    def hold(self) -> Iterator[None]:
+        """Keep time from advancing while in the context, e.g. while starting threads."""
+        yield
+
+
+class VirtualClock(Clock):
+    """
+    Discrete-event clock, which advances instantly whenever all of its threads are blocked.
+
+    .. note::
+        Threads started by `start_thread` are tracked by the clock. When all of them are blocked
+        in `sleep` or `wait`, time jumps to the earliest deadline among their sleeps and timeouts,
+        and the threads due at that time are woken up. Ticks of the medium are therefore
+        processed in exactly the same order as with the wall clock, but without waiting for them,
+        and computation takes no time at all. Time stops advancing once all threads started by
+        `start_thread` have returned, apart from service threads such as the ticker of the medium.
+    """
+
+    class _Waiter:
+        def __init__(self, *, tracked: bool) -> None:
+            self.tracked = tracked
+            self.done = False
+
+    def __init__(self) -> None:
+        self._cond = threading.Condition()
+        self._local = threading.local()
+        self._now = 0.0
+        self._active = 0
+        self._clients = 0
+        self._timers: list[tuple[float, int, VirtualClock._Waiter]] = []
+        self._waiters: dict[Event, VirtualClock._Waiter] = {}
+        self._seq = itertools.count()
+
+    def time(self) -> float:
+        return self._now
+
+    def sleep(self, seconds: float) -> None:
+        self._block(None, seconds)
+
+    def wait(self, event: Event, timeout: float | None = None) -> bool:
+        return self._block(event, timeout)
+
+    def set(self, event: Event) -> None:
+        with self._cond:
+            event.flag.set()
+            if (waiter := self._waiters.get(event)) is not None:
+                self._wake(waiter)
+                self._cond.notify_all()
+
+    def start_thread(
+        self,
+        target: Callable[..., None],
+        args: Sequence[Any] = (),
+        *,
+        service: bool = False,
+    ) -> threading.Thread:
+        clients = 0 if service else 1
+        with self._cond:
+            self._active += 1
+            self._clients += clients
+
+        def run() -> None:
+            self._local.tracked = True
+            try:
+                target(*args)
+            finally:
+                with self._cond:
+                    self._active -= 1
+                    self._clients -= clients
+                    self._advance()
+
+        return super().start_thread(run)
+
+    @contextlib.contextmanager
+    def hold(self) -> Iterator[None]:
+        with self._cond:
+            self._active += 1
+            self._clients += 1
+        try:
+            yield
+        finally:
+            with self._cond:
+                self._active -= 1
+                self._clients -= 1
+                self._advance()
+
+    def _block(self, event: Event | None, timeout: float | None) -> bool:
+        with self._cond:
+            if event is not None and event.flag.is_set():
+                return True
+            waiter = self._Waiter(tracked=getattr(self._local, "tracked", False))
+            if event is not None:
+                self._waiters[event] = waiter
+            if timeout is not None:
+                deadline = self._now + max(0.0, timeout)
+                heapq.heappush(self._timers, (deadline, next(self._seq), waiter))
+            if waiter.tracked:
+                self._active -= 1
+                self._advance()
+            while not waiter.done:
+                self._cond.wait()
+            if event is None:
+                return True
+            del self._waiters[event]
+            return event.flag.is_set()
+
+    def _wake(self, waiter: VirtualClock._Waiter) -> None:
+        if not waiter.done:
+            waiter.done = True
+            self._active += waiter.tracked
+
+    def _advance(self) -> None:
+        while self._active == 0 and self._clients > 0 and self._timers:
+            deadline, _, waiter = heapq.heappop(self._timers)
+            if waiter.done:
+                continue
+            self._now = max(self._now, deadline)
+            self._wake(waiter)
+            while self._timers and self._timers[0][0] <= self._now:
+                self._wake(heapq.heappop(self._timers)[2])
+            self._cond.notify_all()
+
+
 class Event:
     PEEK_TOKEN = "__peek__"  # noqa: S105
 
-    def __init__(self, priority: int, token: str | None = None) -> None:
+    def __init__(self, priority: int, token: str | None = None, clock: Clock | None = None) -> None:
         self.priority = priority
         self.token = token
-        self._event = threading.Event()
+        self.flag = threading.Event()
+        self._clock = clock or Clock()
 
     def __repr__(self) -> str:
         return f"Event(priority={self.priority}, token={self.token})"
 
     def wait(self, timeout: float | None = None) -> None:
-        if not self._event.wait(timeout):
+        if not self._clock.wait(self, timeout):
             err_msg = f"Timed out after {timeout:g} seconds"
             raise TimeoutError(err_msg)
 
     def set(self) -> None:
-        self._event.set()
+        self._clock.set(self)
 
 
 class EventQueue:
-    def __init__(self, name: str) -> None:
+    def __init__(self, name: str, clock: Clock | None = None) -> None:
         self.name = name
+        self._clock = clock or Clock()
         self._queue: list[Event] = []
         self._dummy = Event(0)
         self.token: str | None = None
@@ -481,10 +729,13 @@ class EventQueue:
         token: str | None = None,
         timeout: float | None = None,
     ) -> None:
-        event = Event(priority, token)
+        event = Event(priority, token, self._clock)
+        self.push(event)
+        event.wait(timeout)
+
+    def push(self, event: Event) -> None:
         log.debug("[%s] Enqueued: %s", self.name, event)
         self._queue.append(event)
-        event.wait(timeout)
 
     def dequeue(self) -> None:
         i, event = self._next()
@@ -501,33 +752,98 @@ class EventQueue:
             self.dequeue()
 
 
+class _Subscription:
+    def __init__(self, predicate: Callable[[Message], bool], clock: Clock) -> None:
+        self.predicate = predicate
+        self.event = Event(0, clock=clock)
+        self.msg = Message.empty()
+
+    def notify(self, msg: Message) -> bool:
+        if not self.predicate(msg):
+            return False
+        self.msg = msg
+        self.event.set()
+        return True
+
+
 class Medium:
     @property
     def interval(self) -> float:
         return self._interval
 
-    def __init__(self, interval: float = 1.0) -> None:
+    @property
+    def clock(self) -> Clock:
+        return self._clock
+
+    def __init__(
+        self,
+        interval: float = 1.0,
+        clock: Clock | None = None,
+        recorder: TraceRecorder | None = None,
+    ) -> None:
         self._msg: Message = Message.empty()
         self._interval = interval
-        self._write_queue = EventQueue("Write")
-        self._read_queue = EventQueue("Read")
-        self._wait_queue = EventQueue("Wait")
-        threading.Thread(target=self._tick, daemon=True).start()
+        self._clock = clock or Clock()
+        self._recorder = recorder
+        self._ticks = 0
+        self._subscribers: list[_Subscription] = []
+        self._subscribers_lock = threading.Lock()
+        self._write_queue = EventQueue("Write", self._clock)
+        self._read_queue = EventQueue("Read", self._clock)
+        self._wait_queue = EventQueue("Wait", self._clock)
+        self._clock.start_thread(self._tick, service=True)
 
     def _tick(self) -> None:
         for i in itertools.count(start=1):
-            time.sleep(self._interval)
+            self._clock.sleep(self._interval)
             log.debug("[Medium] Tick %d", i)
+            self._ticks = i
             if len(self._write_queue) and self._read_queue.token is None:
                 self._write_queue.dequeue()
-                time.sleep(self._interval)
+                self._clock.sleep(self._interval)
             if not self._msg.is_empty:
                 self._read_queue.dequeue()
             self._wait_queue.dequeue_all()
 
+    def _set_msg(self, msg: Message) -> None:
+        with self._subscribers_lock:
+            self._msg = msg
+            if self._subscribers:
+                self._subscribers = [s for s in self._subscribers if not s.notify(msg)]
+
     def peek(self) -> Message:
         return self._msg.copy()
 
+    def subscribe(
+        self,
+        predicate: Callable[[Message], bool],
+        *,
+        timeout: float | None = None,
+    ) -> Message:
+        """
+        Wait until the message on the medium satisfies a predicate.
+
+        .. note::
+            Subscribers are woken up by the thread that changes the message, rather than by
+            polling the medium. The predicate is called while the message is being changed,
+            so it must be fast and must not modify the message.
+
+        :param predicate: The predicate.
+        :param timeout: The maximum time to wait, in seconds.
+        :return: A copy of the message that satisfied the predicate.
+        """
+        subscription = _Subscription(predicate, self._clock)
+        with self._subscribers_lock:
+            if predicate(self._msg):
+                return self._msg.copy()
+            self._subscribers.append(subscription)
+        try:
+            subscription.event.wait(timeout)
+        finally:
+            with self._subscribers_lock:
+                self._subscribers = [s for s in self._subscribers if s is not subscription]
+        return subscription.msg.copy()
+
     def read(
         self,
         recipient: str | None,
@@ -539,7 +855,7 @@ class Medium:
         self._read_queue.enqueue(priority=priority, token=recipient, timeout=timeout)
         if clear:
             msg = self._msg
-            self._msg = Message.empty()
+            self._set_msg(Message.empty())
         else:
             msg = self._msg.copy()
         return msg
@@ -547,7 +863,9 @@ class Medium:
     def write(self, msg: Message, priority: int, *, timeout: float | None = None) -> None:
         self._write_queue.enqueue(priority=priority, timeout=timeout)
         self._read_queue.token = msg.recipient
-        self._msg = msg.copy()
+        self._set_msg(msg.copy())
+        if self._recorder is not None:
+            self._recorder.record(self._ticks, priority, msg)
 
     def wait(self, turns: int = 1) -> None:
         for _ in range(turns):
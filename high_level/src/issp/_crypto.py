@@ -1,22 +1,24 @@
 from __future__ import annotations
 
+import itertools
 import math
 import os
 from typing import TYPE_CHECKING
 
+from cryptography.exceptions import InvalidTag
 from cryptography.hazmat.primitives import ciphers, serialization
 from cryptography.hazmat.primitives.asymmetric import (
     padding as asymmetric_padding,
     rsa,
 )
-from cryptography.hazmat.primitives.ciphers import algorithms, modes
+from cryptography.hazmat.primitives.ciphers import aead, algorithms, modes
 
 from ._bytes import blocks, split, xor
 from ._comm import Layer, Message
 from ._pad import pkcs1v15_unpad, pkcs7_pad, pkcs7_unpad
 
 if TYPE_CHECKING:
-    from collections.abc import Iterator
+    from collections.abc import Callable, Iterator
 
 
 class Cipher(Layer):
@@ -62,7 +64,7 @@ class Cipher(Layer):
         :returns: The size of the ciphertext in bytes.
         """
         plaintext = b"\x00" * plaintext if isinstance(plaintext, int) else plaintext
-        iv = b"x\00" * self.iv_size if self.iv_size else b""
+        iv = b"\x00" * self.iv_size if self.iv_size else b""
         return len(self.encrypt(plaintext, iv=iv))
 
     def generate_iv(self) -> bytes:
@@ -142,6 +144,16 @@ class StreamCipher(SymmetricCipher):
         """
         raise NotImplementedError
 
+    def key_stream_bytes(self, iv: bytes, size: int) -> bytes:
+        """
+        Generate a chunk of keystream in a single call.
+
+        :param iv: The initialization vector (IV) to use for keystream generation.
+        :param size: The number of keystream bytes to generate.
+        :returns: The first `size` keystream bytes.
+        """
+        return bytes(itertools.islice(self.key_stream(iv), size))
+
     def encrypt(self, data: bytes, *, iv: bytes = b"") -> bytes:
         return xor(data, self.key_stream(iv))
 
@@ -152,6 +164,15 @@ class StreamCipher(SymmetricCipher):
 class BlockCipherMode(Cipher):
     """Base class for block cipher modes of operation."""
 
+    @property
+    def cipher(self) -> BlockCipher:
+        """The underlying block cipher."""
+        return self._cipher
+
+    @property
+    def iv_size(self) -> int:
+        return self._cipher.iv_size
+
     @property
     def key(self) -> bytes:
         return self._cipher.key
@@ -182,6 +203,13 @@ class BlockCipherMode(Cipher):
 class ECB(BlockCipherMode):
     """Electronic Codebook (ECB) mode of operation."""
 
+    @property
+    def iv_size(self) -> int:
+        return 0
+
+    def generate_iv(self) -> bytes:
+        return b""
+
     def encrypt(self, data: bytes, *, iv: bytes = b"") -> bytes:
         del iv  # unused
         array = bytearray()
@@ -226,6 +254,14 @@ class CTR(BlockCipherMode, StreamCipher):
             yield from self._cipher.encrypt(counter.to_bytes(self.block_size))
             counter += 1
 
+    def key_stream_bytes(self, iv: bytes, size: int) -> bytes:
+        if not isinstance(self._cipher, AES256):
+            return super().key_stream_bytes(iv, size)
+        # Native CTR mode increments the whole block as a big-endian counter, like key_stream.
+        iv = (int.from_bytes(iv) % 2 ** (self.block_size * 8)).to_bytes(self.block_size)
+        cipher = ciphers.Cipher(algorithms.AES256(self.key), mode=modes.CTR(iv))
+        return cipher.encryptor().update(bytes(size))
+
 
 class OTP(BaseSymmetricCipher, StreamCipher):
     """One-Time Pad (OTP) cipher with 256 bytes key."""
@@ -243,21 +279,34 @@ class AES256(BaseSymmetricCipher, BlockCipher):
     KEY_SIZE = 32
     BLOCK_SIZE = 16
 
+    def __init__(self, key: bytes | None = None) -> None:
+        super().__init__(key)
+        self._contexts_key = b""
+        self._encryptor: ciphers.CipherContext | None = None
+        self._decryptor: ciphers.CipherContext | None = None
+
+    def _contexts(self) -> tuple[ciphers.CipherContext, ciphers.CipherContext]:
+        # ECB contexts are stateless across blocks, so they are kept for as long as the key is.
+        if self._encryptor is None or self._decryptor is None or self._contexts_key != self.key:
+            cipher = ciphers.Cipher(algorithms.AES256(self.key), mode=modes.ECB())  # noqa: S305
+            self._contexts_key = self.key
+            self._encryptor = cipher.encryptor()
+            self._decryptor = cipher.decryptor()
+        return self._encryptor, self._decryptor
+
     def encrypt(self, data: bytes, *, iv: bytes = b"") -> bytes:
         del iv  # unused
         if (data_len := len(data)) != self.block_size:
             msg = f"Data ({data_len} B) must be {self.block_size} B"
             raise ValueError(msg)
-        cipher = ciphers.Cipher(algorithms.AES256(self.key), mode=modes.ECB())  # noqa: S305
-        return cipher.encryptor().update(data)
+        return self._contexts()[0].update(data)
 
     def decrypt(self, data: bytes, *, iv: bytes = b"") -> bytes:
         del iv  # unused
         if (data_len := len(data)) != self.block_size:
             msg = f"Data ({data_len} B) must be {self.block_size} B"
             raise ValueError(msg)
-        cipher = ciphers.Cipher(algorithms.AES256(self.key), mode=modes.ECB())  # noqa: S305
-        return cipher.decryptor().update(data)
+        return self._contexts()[1].update(data)
 
 
 class ChaCha20(BaseSymmetricCipher, StreamCipher):
@@ -273,6 +322,74 @@ class ChaCha20(BaseSymmetricCipher, StreamCipher):
             yield from cipher.encryptor().update(buf)
 
 
+class AEAD(BaseSymmetricCipher):
+    """
+    Base class for authenticated encryption with associated data (AEAD) ciphers.
+
+    .. note::
+        AEAD ciphers encrypt and authenticate in a single pass, so they replace a stack such as
+        ``HMAC() | ChaCha20(key)`` with a single native call per message. Encoded messages are
+        laid out as nonce || ciphertext || tag, and decoding fails if the tag does not match.
+    """
+
+    KEY_SIZE = 32
+    IV_SIZE = 12
+    TAG_SIZE = 16
+    _ALGORITHM: Callable[[bytes], aead.ChaCha20Poly1305 | aead.AESGCM]
+
+    @property
+    def key(self) -> bytes:
+        return self._key
+
+    @key.setter
+    def key(self, value: bytes) -> None:
+        self._key = bytes(value)
+        self._context = self._ALGORITHM(self._key)
+
+    def __init__(self, key: bytes | None = None, associated_data: bytes | None = None) -> None:
+        """
+        Initialize the cipher.
+
+        :param key: The key. If None, a random key is generated.
+        :param associated_data: Data authenticated along with each message, but not encrypted.
+        """
+        super().__init__(key)
+        self._context = self._ALGORITHM(self._key)
+        self.associated_data = associated_data
+        """Data authenticated along with each message, but not encrypted."""
+
+    def encrypt(self, data: bytes, *, iv: bytes = b"") -> bytes:
+        return self._context.encrypt(iv, data, self.associated_data)
+
+    def decrypt(self, data: bytes, *, iv: bytes = b"") -> bytes:
+        try:
+            return self._context.decrypt(iv, data, self.associated_data)
+        except InvalidTag:
+            err_msg = "Message verification failed"
+            raise ValueError(err_msg) from None
+
+    def ciphertext_size(self, plaintext: int | bytes) -> int:
+        size = plaintext if isinstance(plaintext, int) else len(plaintext)
+        return size + self.TAG_SIZE
+
+    def decode(self, msg: Message) -> Message:
+        body = memoryview(msg.body)
+        msg.body = self.decrypt(body[self.iv_size :], iv=body[: self.iv_size])
+        return msg
+
+
+class ChaCha20Poly1305(AEAD):
+    """ChaCha20-Poly1305 AEAD cipher."""
+
+    _ALGORITHM = aead.ChaCha20Poly1305
+
+
+class AES256GCM(AEAD):
+    """AES256-GCM AEAD cipher."""
+
+    _ALGORITHM = aead.AESGCM
+
+
 class AsymmetricKey(Cipher):
     """Base class for asymmetric keys."""
 
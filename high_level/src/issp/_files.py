@@ -0,0 +1,216 @@
+from __future__ import annotations
+
+import mmap
+import tempfile
+from bisect import bisect_left, bisect_right
+from collections.abc import Iterator, Mapping, MutableMapping
+from typing import TYPE_CHECKING, Self
+
+if TYPE_CHECKING:
+    from pathlib import Path
+    from types import TracebackType
+
+# Files are sequences of chunks, one per append, indexed by the cumulative number of characters
+# at the end of each chunk, so that appends never copy existing data and range reads only touch
+# the chunks that overlap the range.
+
+
+def _span(ends: list[int], start: int, stop: int) -> tuple[int, int]:
+    # Indexes of the first and last chunks overlapping the non-empty range [start, stop).
+    return bisect_right(ends, start), bisect_left(ends, stop)
+
+
+class _MemoryFile:
+    def __init__(self) -> None:
+        self.chunks: list[str] = []
+        self.ends: list[int] = []
+
+    @property
+    def size(self) -> int:
+        return self.ends[-1] if self.ends else 0
+
+    def append(self, data: str) -> None:
+        self.chunks.append(data)
+        self.ends.append(self.size + len(data))
+
+    def read(self, start: int, stop: int) -> str:
+        if start == 0 and stop == self.size and len(self.chunks) > 1:
+            # Whole reads compact the file, so that repeated reads do not join the chunks again.
+            self.chunks = ["".join(self.chunks)]
+            self.ends = [self.size]
+        first, last = _span(self.ends, start, stop)
+        chunk_start = self.ends[first - 1] if first else 0
+        data = "".join(self.chunks[first : last + 1])
+        return data[start - chunk_start : stop - chunk_start]
+
+    def close(self) -> None:
+        self.chunks.clear()
+        self.ends.clear()
+
+
+class _MappedFile:
+    # UTF-8 chunks stored in a memory-mapped temporary file, whose capacity doubles when full.
+
+    def __init__(self, directory: str | Path | None) -> None:
+        self._file = tempfile.TemporaryFile(dir=directory)  # noqa: SIM115
+        self._capacity = mmap.PAGESIZE
+        self._file.truncate(self._capacity)
+        self._mmap = mmap.mmap(self._file.fileno(), self._capacity)
+        self.ends: list[int] = []
+        self.byte_ends: list[int] = []
+
+    @property
+    def size(self) -> int:
+        return self.ends[-1] if self.ends else 0
+
+    @property
+    def byte_size(self) -> int:
+        return self.byte_ends[-1] if self.byte_ends else 0
+
+    def append(self, data: str) -> None:
+        encoded = data.encode()
+        start, stop = self.byte_size, self.byte_size + len(encoded)
+        if stop > self._capacity:
+            while stop > self._capacity:
+                self._capacity *= 2
+            self._mmap.close()
+            self._file.truncate(self._capacity)
+            self._mmap = mmap.mmap(self._file.fileno(), self._capacity)
+        self._mmap[start:stop] = encoded
+        self.ends.append(self.size + len(data))
+        self.byte_ends.append(stop)
+
+    def read(self, start: int, stop: int) -> str:
+        first, last = _span(self.ends, start, stop)
+        chunk_start = self.ends[first - 1] if first else 0
+        byte_start = self.byte_ends[first - 1] if first else 0
+        data = self._mmap[byte_start : self.byte_ends[last]].decode()
+        return data[start - chunk_start : stop - chunk_start]
+
+    def close(self) -> None:
+        self._mmap.close()
+        self._file.close()
+
+
+class FileStore(MutableMapping[str, str]):
+    """
+    Storage for the text files of a `FileServer`.
+
+    Behaves like a dictionary mapping paths to contents, but files can also be appended to
+    in time proportional to the appended data, and read in ranges.
+
+    .. note::
+        Each file is stored as the list of its appended chunks, which are only joined when the
+        whole file is read. Files that grow past `spill_size` characters are moved to
+        memory-mapped temporary files, so that large logs do not need to fit in memory.
+    """
+
+    @property
+    def spill_size(self) -> int | None:
+        """Size in characters above which files are moved to disk, or None if they never are."""
+        return self._spill_size
+
+    def __init__(
+        self,
+        files: Mapping[str, str] | None = None,
+        *,
+        spill_size: int | None = None,
+        directory: str | Path | None = None,
+    ) -> None:
+        """
+        Create a file store.
+
+        :param files: Initial files, mapping paths to contents.
+        :param spill_size: Size in characters above which files are moved to disk.
+                           If None, files are always kept in memory.
+        :param directory: Directory of the spilled files. If None, the system default is used.
+        """
+        self._spill_size = spill_size
+        self._directory = directory
+        self._files: dict[str, _MemoryFile | _MappedFile] = {}
+        if files:
+            self.update(files)
+
+    def __getitem__(self, path: str) -> str:
+        return self.read(path)
+
+    def __setitem__(self, path: str, data: str) -> None:
+        if old := self._files.pop(path, None):
+            old.close()
+        self._files[path] = _MemoryFile()
+        self.append(path, data)
+
+    def __delitem__(self, path: str) -> None:
+        self._files.pop(path).close()
+
+    def __iter__(self) -> Iterator[str]:
+        return iter(self._files)
+
+    def __len__(self) -> int:
+        return len(self._files)
+
+    def size(self, path: str) -> int:
+        """
+        Return the size of a file.
+
+        :param path: Path of the file.
+        :return: Size of the file, in characters.
+        """
+        return self._files[path].size
+
+    def append(self, path: str, data: str) -> None:
+        """
+        Append data to an existing file.
+
+        :param path: Path of the file.
+        :param data: Data to append.
+        """
+        file = self._files[path]
+        if not data:
+            return
+        if (
+            isinstance(file, _MemoryFile)
+            and self._spill_size is not None
+            and file.size + len(data) > self._spill_size
+        ):
+            file = self._spill(path, file)
+        file.append(data)
+
+    def read(self, path: str, offset: int = 0, length: int | None = None) -> str:
+        """
+        Read a range of a file.
+
+        :param path: Path of the file.
+        :param offset: Offset of the first character to read.
+        :param length: Maximum number of characters to read. If None, reads until the end.
+        :return: The data, which is shorter than `length` if the range exceeds the file.
+        """
+        if offset < 0 or (length is not None and length < 0):
+            err_msg = "Offset and length must not be negative"
+            raise ValueError(err_msg)
+        file = self._files[path]
+        stop = file.size if length is None else min(offset + length, file.size)
+        return file.read(offset, stop) if offset < stop else ""
+
+    def _spill(self, path: str, file: _MemoryFile) -> _MappedFile:
+        mapped = _MappedFile(self._directory)
+        if file.size:
+            mapped.append(file.read(0, file.size))
+        file.close()
+        self._files[path] = mapped
+        return mapped
+
+    def close(self) -> None:
+        """Remove all files, releasing the spilled ones."""
+        self.clear()
+
+    def __enter__(self) -> Self:
+        return self
+
+    def __exit__(
+        self,
+        exc_type: type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        self.close()
@@ -0,0 +1,301 @@
+from __future__ import annotations
+
+import argparse
+import hmac
+import itertools
+import sys
+from typing import TYPE_CHECKING
+
+from cryptography.hazmat.primitives import ciphers
+from cryptography.hazmat.primitives.ciphers import algorithms, modes
+
+from . import _log as log
+from ._bytes import split
+from ._comm import Layer, Message, Stack
+from ._crypto import AES256, CBC, CTR, ECB, BlockCipherMode
+from ._pad import pkcs7_pad, pkcs7_unpad
+from ._verify import HMAC, SHA1, SHA256
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Iterator, Sequence
+
+
+class Fused(Layer):
+    """
+    A layer that replaces one or more layers of a stack with an equivalent, faster implementation.
+
+    Fused layers are created by `Stack` according to its fusion rules, and produce exactly
+    the same bytes as the layers they replace.
+    """
+
+    @property
+    def layers(self) -> Sequence[Layer]:
+        """The layers replaced by this layer."""
+        return self._layers
+
+    def __init__(self, *layers: Layer) -> None:
+        self._layers = layers
+
+    def __repr__(self) -> str:
+        return f"{self.__class__.__name__}{self._layers!r}"
+
+
+class _NativeMode(Fused):
+    """AES256 in ECB, CBC or CTR mode, backed by a single native cipher context per message."""
+
+    def __init__(self, mode: BlockCipherMode) -> None:
+        super().__init__(mode)
+        self._mode = mode
+
+    def _context(self, iv: bytes) -> ciphers.Cipher[modes.Mode]:
+        key = algorithms.AES256(self._mode.key)
+        if isinstance(self._mode, CTR):
+            # Like CTR.key_stream, the whole block is a big-endian counter.
+            iv = (int.from_bytes(iv) % 2**128).to_bytes(AES256.BLOCK_SIZE)
+            return ciphers.Cipher(key, modes.CTR(iv))
+        if isinstance(self._mode, CBC):
+            return ciphers.Cipher(key, modes.CBC(iv))
+        return ciphers.Cipher(key, modes.ECB())  # noqa: S305
+
+    def _is_native(self, iv: bytes, data: bytes = b"") -> bool:
+        # Inputs the native contexts would reject are left to the original layer, so that
+        # errors are the same too.
+        if isinstance(self._mode, CTR):
+            return True
+        if isinstance(self._mode, CBC) and len(iv) != AES256.BLOCK_SIZE:
+            return False
+        return len(data) % AES256.BLOCK_SIZE == 0
+
+    def encrypt(self, data: bytes, iv: bytes) -> bytes:
+        if isinstance(self._mode, CTR):
+            return self._context(iv).encryptor().update(data)
+        if not self._is_native(iv):
+            return self._mode.encrypt(data, iv=iv)
+        encryptor = self._context(iv).encryptor()
+        return encryptor.update(pkcs7_pad(data, AES256.BLOCK_SIZE)) + encryptor.finalize()
+
+    def decrypt(self, data: bytes, iv: bytes) -> bytes:
+        if not self._is_native(iv, data):
+            return self._mode.decrypt(data, iv=iv)
+        plaintext = self._context(iv).decryptor().update(data)
+        if isinstance(self._mode, CTR):
+            return plaintext
+        return pkcs7_unpad(plaintext, AES256.BLOCK_SIZE)
+
+    def seal(self, data: bytes) -> bytes:
+        iv = self._mode.generate_iv()
+        return iv + self.encrypt(data, iv)
+
+    def open(self, data: bytes) -> bytes:
+        iv, body = split(data, self._mode.iv_size)
+        return self.decrypt(body, iv)
+
+    def encode(self, msg: Message) -> Message:
+        msg.body = self.seal(msg.body)
+        return msg
+
+    def decode(self, msg: Message) -> Message:
+        msg.body = self.open(msg.body)
+        return msg
+
+
+class _NativeHMAC(Fused):
+    """HMAC-SHA1 or HMAC-SHA256, computed by `hmac.digest`."""
+
+    def __init__(self, mac: HMAC, digest: str) -> None:
+        super().__init__(mac)
+        self._mac = mac
+        self._digest = digest
+
+    def compute_code(self, data: bytes) -> bytes:
+        # The HMAC key is already padded to the block size, which leaves it unchanged.
+        return hmac.digest(self._mac.key, data, self._digest)
+
+    def check(self, data: bytes) -> bytes:
+        code, body = split(data, self._mac.code_size)
+        if not hmac.compare_digest(self.compute_code(body), code):
+            err_msg = "Message verification failed"
+            raise ValueError(err_msg)
+        return body
+
+    def encode(self, msg: Message) -> Message:
+        msg.body = self.compute_code(msg.body) + msg.body
+        return msg
+
+    def decode(self, msg: Message) -> Message:
+        msg.body = self.check(msg.body)
+        return msg
+
+
+class _EncryptThenMAC(Fused):
+    """Native encryption followed by native HMAC, e.g. ``CBC(AES256()) | HMAC()``."""
+
+    def __init__(self, mode: _NativeMode, mac: _NativeHMAC) -> None:
+        super().__init__(*mode.layers, *mac.layers)
+        self._mode = mode
+        self._mac = mac
+
+    def encode(self, msg: Message) -> Message:
+        data = self._mode.seal(msg.body)
+        msg.body = self._mac.compute_code(data) + data
+        return msg
+
+    def decode(self, msg: Message) -> Message:
+        msg.body = self._mode.open(self._mac.check(msg.body))
+        return msg
+
+
+class _MACThenEncrypt(Fused):
+    """Native HMAC followed by native encryption, e.g. ``HMAC() | CTR(AES256())``."""
+
+    def __init__(self, mac: _NativeHMAC, mode: _NativeMode) -> None:
+        super().__init__(*mac.layers, *mode.layers)
+        self._mac = mac
+        self._mode = mode
+
+    def encode(self, msg: Message) -> Message:
+        msg.body = self._mode.seal(self._mac.compute_code(msg.body) + msg.body)
+        return msg
+
+    def decode(self, msg: Message) -> Message:
+        msg.body = self._mac.check(self._mode.open(msg.body))
+        return msg
+
+
+# Only exact types are fused, since subclasses may override any part of the algorithm.
+_NATIVE_MODES = (ECB, CBC, CTR)
+_NATIVE_DIGESTS = {SHA1: "sha1", SHA256: "sha256"}
+
+
+def _native_mode(layer: Layer) -> _NativeMode | None:
+    if (
+        isinstance(layer, BlockCipherMode)
+        and type(layer) in _NATIVE_MODES
+        and type(layer.cipher) is AES256
+    ):
+        return _NativeMode(layer)
+    return None
+
+
+def _native_hmac(layer: Layer) -> _NativeHMAC | None:
+    if (
+        isinstance(layer, HMAC)
+        and type(layer) is HMAC
+        and (digest := _NATIVE_DIGESTS.get(type(layer.hash_fn)))
+    ):
+        return _NativeHMAC(layer, digest)
+    return None
+
+
+def _fuse_pair(layers: Sequence[Layer]) -> tuple[Layer, int] | None:
+    if len(layers) < 2:  # noqa: PLR2004
+        return None
+    if (mode := _native_mode(layers[0])) and (mac := _native_hmac(layers[1])):
+        return _EncryptThenMAC(mode, mac), 2
+    if (mac := _native_hmac(layers[0])) and (mode := _native_mode(layers[1])):
+        return _MACThenEncrypt(mac, mode), 2
+    return None
+
+
+def _fuse_single(layers: Sequence[Layer]) -> tuple[Layer, int] | None:
+    if layer := _native_mode(layers[0]) or _native_hmac(layers[0]):
+        return layer, 1
+    return None
+
+
+Stack.add_fusion_rule(_fuse_pair)
+Stack.add_fusion_rule(_fuse_single)
+
+
+def _rule_cases() -> Iterator[tuple[str, type[Fused], Callable[[], list[Layer]]]]:
+    # One case per combination of layers that a fusion rule replaces, with the expected fused layer.
+    modes_ = {m.__name__: m for m in _NATIVE_MODES}
+    digests = {d.__name__: d for d in _NATIVE_DIGESTS}
+    key = bytes(range(AES256.KEY_SIZE))
+
+    def mode(name: str) -> BlockCipherMode:
+        return modes_[name](AES256(key))
+
+    def mac(name: str) -> HMAC:
+        return HMAC(digests[name](), key[::-1])
+
+    for m in modes_:
+        yield f"{m}(AES256())", _NativeMode, lambda m=m: [mode(m)]
+    for d in digests:
+        yield f"HMAC({d}())", _NativeHMAC, lambda d=d: [mac(d)]
+    for m, d in itertools.product(modes_, digests):
+        yield f"{m}(AES256()) | HMAC({d}())", _EncryptThenMAC, lambda m=m, d=d: [mode(m), mac(d)]
+        yield f"HMAC({d}()) | {m}(AES256())", _MACThenEncrypt, lambda m=m, d=d: [mac(d), mode(m)]
+
+
+def _outcome(stack: Stack, body: bytes) -> bytes | str:
+    try:
+        return stack.decode(Message("Alice", "Bob", body)).body
+    except Exception as e:
+        return f"{type(e).__name__}: {e}"
+
+
+def check_fusion_rules(sizes: Sequence[int] = (0, 5, 16, 32, 1000)) -> list[str]:
+    """
+    Check that every fusion rule produces exactly the same bytes as the layers it replaces.
+
+    For each combination of layers replaced by a rule and each body size, the fused and unfused
+    stacks must produce the same encoded bytes with the same IV, decode each other's output,
+    and fail in the same way on tampered messages.
+
+    :param sizes: Sizes of the message bodies to check, in bytes.
+    :return: Descriptions of the mismatches, empty if every rule is equivalent.
+    """
+    failures: list[str] = []
+    for name, expected, factory in _rule_cases():
+        layers = factory()
+        for i, layer in enumerate(layers):
+            if isinstance(layer, BlockCipherMode):
+                iv = bytes(range(i, i + layer.iv_size))
+                layer.generate_iv = lambda iv=iv: iv
+        fused, plain = Stack(*layers), Stack(*layers, optimize=False)
+
+        # Classes are compared by name, since they differ when run with `python -m`.
+        pipeline = fused._pipeline  # noqa: SLF001
+        if len(pipeline) != 1 or type(pipeline[0]).__name__ != expected.__name__:
+            failures.append(f"{name}: fused into {pipeline!r} instead of {expected.__name__}")
+            continue
+
+        for size in sizes:
+            body = bytes(i * 7 % 256 for i in range(size))
+            enc = fused.encode(Message("Alice", "Bob", body)).body
+            ref = plain.encode(Message("Alice", "Bob", body)).body
+            tampered = ref[:-1] + bytes([ref[-1] ^ 1]) if ref else ref
+            if enc != ref:
+                failures.append(f"{name}, {size} B: encoded bytes differ")
+            elif _outcome(fused, ref) != body or _outcome(plain, enc) != body:
+                failures.append(f"{name}, {size} B: decoded bodies differ")
+            elif (got := _outcome(fused, tampered)) != (want := _outcome(plain, tampered)):
+                failures.append(f"{name}, {size} B: tampered message gives {got!r}, not {want!r}")
+    return failures
+
+
+def main(argv: Sequence[str] | None = None) -> None:
+    parser = argparse.ArgumentParser(
+        prog="python -m issp._fuse",
+        description="Check that every fusion rule is equivalent to the layers it replaces.",
+    )
+    parser.add_argument(
+        "-s",
+        "--sizes",
+        type=int,
+        nargs="+",
+        default=[0, 5, 16, 32, 1000],
+        help="message body sizes to check (B)",
+    )
+    args = parser.parse_args(argv)
+
+    if failures := check_fusion_rules(args.sizes):
+        for failure in failures:
+            log.error("[Fuse] %s", failure)
+        sys.exit(1)
+    log.info("[Fuse] All %d layer combinations are equivalent.", len(list(_rule_cases())))
+
+
+if __name__ == "__main__":
+    main()
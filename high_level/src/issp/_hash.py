@@ -1,7 +1,82 @@
+import json
+import os
+from pathlib import Path
+from typing import NamedTuple
+
 from cryptography.hazmat.primitives import hashes
 from cryptography.hazmat.primitives.kdf.scrypt import Scrypt
 
 
+class ScryptParams(NamedTuple):
+    """Scrypt cost parameters."""
+
+    n: int = 2**14
+    """CPU/memory cost."""
+    r: int = 8
+    """Block size."""
+    p: int = 1
+    """Parallelization."""
+
+    @property
+    def memory(self) -> int:
+        """Memory required by a single derivation, in bytes."""
+        return 128 * self.r * self.n * self.p
+
+
+SCRYPT_PROFILE_ENV = "ISSP_SCRYPT_PROFILE"
+"""Environment variable holding the path of the scrypt profile to load on first use."""
+
+# None until `scrypt_params` first loads the profile, so that a broken profile only affects scrypt.
+_scrypt_params: ScryptParams | None = None
+_SCRYPT_FAST_PARAMS = ScryptParams(n=2**8)
+
+
+def scrypt_params() -> ScryptParams:
+    """
+    Return the parameters currently used by `scrypt`.
+
+    On first use, they are loaded from the profile pointed to by the `ISSP_SCRYPT_PROFILE`
+    environment variable, if set, and default to `ScryptParams()` otherwise.
+
+    :return: The scrypt parameters.
+    """
+    if _scrypt_params is not None:
+        return _scrypt_params
+    if not (path := os.environ.get(SCRYPT_PROFILE_ENV)):
+        set_scrypt_params(ScryptParams())
+        return ScryptParams()
+    try:
+        return load_scrypt_profile(path)
+    except (OSError, ValueError, KeyError, TypeError) as e:
+        err_msg = f"Cannot load the scrypt profile {path} set by {SCRYPT_PROFILE_ENV}: {e}"
+        raise ValueError(err_msg) from e
+
+
+def set_scrypt_params(params: ScryptParams) -> None:
+    """
+    Set the parameters used by `scrypt`.
+
+    Note that hashes computed with different parameters are not comparable.
+
+    :param params: The scrypt parameters.
+    """
+    global _scrypt_params  # noqa: PLW0603
+    _scrypt_params = ScryptParams(*params)
+
+
+def load_scrypt_profile(path: str | Path) -> ScryptParams:
+    """
+    Load a profile emitted by the scrypt calibration tool and use its parameters for `scrypt`.
+
+    :param path: Path of the JSON profile.
+    :return: The loaded parameters.
+    """
+    data = json.loads(Path(path).read_text())
+    params = ScryptParams(data["n"], data["r"], data["p"])
+    set_scrypt_params(params)
+    return params
+
+
 def _hash(data: bytes | str, algorithm: hashes.HashAlgorithm, salt: bytes | None = None) -> bytes:
     digest = hashes.Hash(algorithm)
     digest.update(data.encode() if isinstance(data, str) else data)
@@ -10,8 +85,8 @@ def _hash(data: bytes | str, algorithm: hashes.HashAlgorithm, salt: bytes | None
     return digest.finalize()
 
 
-def _scrypt(data: bytes | str, n: int = 2**14, salt: bytes | None = None) -> bytes:
-    kdf = Scrypt(salt=b"" if salt is None else salt, length=32, n=n, r=8, p=1)
+def _scrypt(data: bytes | str, params: ScryptParams, salt: bytes | None = None) -> bytes:
+    kdf = Scrypt(salt=b"" if salt is None else salt, length=32, n=params.n, r=params.r, p=params.p)
     return kdf.derive(data.encode() if isinstance(data, str) else data)
 
 
@@ -41,11 +116,14 @@ def scrypt(data: bytes | str, salt: bytes | None = None) -> bytes:
     """
     Scrypt hash function.
 
+    Uses the parameters returned by `scrypt_params`, which are loaded on first use from the
+    profile pointed to by the `ISSP_SCRYPT_PROFILE` environment variable, if set.
+
     :param data: The data to be hashed.
     :param salt: Optional salt to be added to the data before hashing.
     :return: The resulting hash.
     """
-    return _scrypt(data, salt=salt)
+    return _scrypt(data, scrypt_params(), salt=salt)
 
 
 def scrypt_fast(data: bytes | str, salt: bytes | None = None) -> bytes:
@@ -56,4 +134,4 @@ def scrypt_fast(data: bytes | str, salt: bytes | None = None) -> bytes:
     :param salt: Optional salt to be added to the data before hashing.
     :return: The resulting hash.
     """
-    return _scrypt(data, salt=salt, n=2**8)
+    return _scrypt(data, _SCRYPT_FAST_PARAMS, salt=salt)
@@ -0,0 +1,550 @@
+from __future__ import annotations
+
+import argparse
+import contextlib
+import json
+import struct
+import tempfile
+import threading
+import time
+from array import array
+from collections.abc import Iterator, Mapping, MutableMapping
+from pathlib import Path
+from typing import TYPE_CHECKING, Any, NamedTuple, Self
+
+from . import _log as log
+from ._comm import BytesAwareJSONDecoder, BytesAwareJSONEncoder
+from ._wal import WriteAheadLog
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Iterable, Sequence
+    from types import TracebackType
+
+type Transfer = tuple[str, str, float]
+
+# Kinds of the records of the write-ahead log of a ledger. Strings are encoded as `_SIZE`
+# followed by UTF-8, amounts as `_AMOUNT`, and fields as a JSON object.
+_OPEN = 1  # owner, balance, fields
+_CLOSE = 2  # owner
+_BALANCE = 3  # owner, balance
+_FIELD = 4  # owner, {name: value}
+_UNSET = 5  # owner, name
+_TRANSFER = 6  # `_COUNT`, then sender, recipient and amount of each transfer
+
+_SIZE = struct.Struct("<H")
+_AMOUNT = struct.Struct("<d")
+_COUNT = struct.Struct("<I")
+
+
+def _pack_str(s: str) -> bytes:
+    data = s.encode()
+    return _SIZE.pack(len(data)) + data
+
+
+class _Reader:
+    def __init__(self, data: bytes) -> None:
+        self._data = data
+        self._pos = 0
+
+    def _unpack(self, s: struct.Struct) -> Any:  # noqa: ANN401
+        (value,) = s.unpack_from(self._data, self._pos)
+        self._pos += s.size
+        return value
+
+    def str(self) -> str:
+        size = self._unpack(_SIZE)
+        self._pos += size
+        return self._data[self._pos - size : self._pos].decode()
+
+    def amount(self) -> float:
+        return self._unpack(_AMOUNT)
+
+    def count(self) -> int:
+        return self._unpack(_COUNT)
+
+    def fields(self) -> dict[str, Any]:
+        return json.loads(self._data[self._pos :], cls=BytesAwareJSONDecoder)
+
+
+class Account(MutableMapping[str, Any]):
+    """
+    The record of an account in a `Ledger`.
+
+    Behaves like the dictionary it was created from, except that its "balance" field is stored
+    in the ledger.
+    """
+
+    def __init__(self, ledger: Ledger, index: int, fields: dict[str, Any]) -> None:
+        self._ledger = ledger
+        self._index = index
+        self._fields = fields
+
+    def __getitem__(self, key: str) -> Any:  # noqa: ANN401
+        if key == Ledger.BALANCE:
+            return self._ledger.balance_at(self._index)
+        return self._fields[key]
+
+    def __setitem__(self, key: str, value: Any) -> None:  # noqa: ANN401
+        if key == Ledger.BALANCE:
+            self._ledger.set_balance_at(self._index, value)
+        else:
+            self._ledger.set_field_at(self._index, key, value)
+
+    def __delitem__(self, key: str) -> None:
+        if key == Ledger.BALANCE:
+            err_msg = "The balance of an account cannot be deleted"
+            raise KeyError(err_msg)
+        self._ledger.unset_field_at(self._index, key)
+
+    def __iter__(self) -> Iterator[str]:
+        yield Ledger.BALANCE
+        yield from self._fields
+
+    def __len__(self) -> int:
+        return len(self._fields) + 1
+
+    def __repr__(self) -> str:
+        return repr(dict(self))
+
+
+class Ledger(MutableMapping[str, Account]):
+    """
+    Bank accounts, indexed by owner.
+
+    .. note::
+        Balances are kept in a compact array, so that transfers take constant time regardless
+        of the number of accounts, and each account is guarded by its own lock, so that
+        concurrent transfers only contend when they involve the same accounts. Assigning
+        a dictionary to an owner opens an account whose record has the same fields,
+        the "balance" field defaulting to zero.
+
+        If the ledger has a write-ahead log, it is recovered from the log when created,
+        and every change is appended to the log before it is applied. Fields are logged as JSON,
+        so those that cannot be encoded, such as OTP generators, are not persisted.
+    """
+
+    BALANCE = "balance"
+
+    @property
+    def transactions(self) -> int:
+        """Number of transfers committed so far."""
+        return self._transactions
+
+    @property
+    def wal(self) -> WriteAheadLog | None:
+        """The write-ahead log of the ledger, if any."""
+        return self._wal
+
+    def __init__(self, wal: WriteAheadLog | None = None, *, synchronous: bool = True) -> None:
+        """
+        Create a ledger.
+
+        :param wal: Write-ahead log from which the ledger is recovered, and to which changes
+                    are appended. If None, the ledger only lives in memory.
+        :param synchronous: Whether changes are durable once applied. If False, changes made
+                            within the durability window of the log may be lost in a crash.
+        """
+        self._index: dict[str, int] = {}
+        self._owners: list[str] = []
+        self._balances = array("d")
+        self._accounts: list[Account] = []
+        self._locks: list[threading.Lock] = []
+        self._free: list[int] = []
+        self._lock = threading.Lock()
+        self._transactions = 0
+        self._synchronous = synchronous
+        self._unpersisted: set[str] = set()
+        self._wal: WriteAheadLog | None = None
+        if wal is not None:
+            for number, (kind, payload) in enumerate(wal.records()):
+                try:
+                    self._replay(kind, _Reader(payload))
+                except KeyError as e:
+                    err_msg = f"Record {number} of the ledger log refers to unknown account {e}"
+                    raise ValueError(err_msg) from None
+            self._wal = wal
+
+    @classmethod
+    def open(cls, path: str | Path, window: float = 0.0, *, synchronous: bool = True) -> Self:
+        """
+        Open a ledger backed by a write-ahead log, recovering it if the log exists.
+
+        :param path: Path of the log.
+        :param window: Durability window of the log, in seconds.
+        :param synchronous: Whether changes are durable once applied.
+        :return: The ledger.
+        """
+        return cls(WriteAheadLog(path, window), synchronous=synchronous)
+
+    def close(self) -> None:
+        """Commit pending changes and close the write-ahead log, if any."""
+        if self._wal is not None:
+            self._wal.close()
+
+    def __enter__(self) -> Self:
+        return self
+
+    def __exit__(
+        self,
+        exc_type: type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        self.close()
+
+    def __getitem__(self, owner: str) -> Account:
+        return self._accounts[self._index[owner]]
+
+    def __setitem__(self, owner: str, record: Mapping[str, Any]) -> None:
+        fields = dict(record)
+        balance = float(fields.pop(self.BALANCE, 0.0))
+        with self._lock:
+            index = self._slot(owner)
+            # New accounts are only published once opened, so that transfers cannot reach them
+            # before their opening is logged.
+            with self._locks[index]:
+                try:
+                    seq = self._append(
+                        _OPEN,
+                        owner,
+                        lambda: _AMOUNT.pack(balance) + self._json(fields),
+                    )
+                except BaseException:
+                    if owner not in self._index:
+                        self._free.append(index)
+                    raise
+                self._balances[index] = balance
+                self._accounts[index] = Account(self, index, fields)
+                self._bind(owner, index)
+        self._commit(seq)
+
+    def __delitem__(self, owner: str) -> None:
+        with self._lock:
+            index = self._index[owner]
+            with self._locks[index]:
+                seq = self._append(_CLOSE, owner)
+                self._close(owner)
+        self._commit(seq)
+
+    def __contains__(self, owner: object) -> bool:
+        return owner in self._index
+
+    def __iter__(self) -> Iterator[str]:
+        return iter(self._index)
+
+    def __len__(self) -> int:
+        return len(self._index)
+
+    def balance_at(self, index: int) -> float:
+        return self._balances[index]
+
+    def set_balance_at(self, index: int, balance: float) -> None:
+        with self._locks[index]:
+            seq = self._append(_BALANCE, self._owner_at(index), lambda: _AMOUNT.pack(balance))
+            self._balances[index] = balance
+        self._commit(seq)
+
+    def set_field_at(self, index: int, key: str, value: Any) -> None:  # noqa: ANN401
+        with self._locks[index]:
+            seq = self._append(_FIELD, self._owner_at(index), lambda: self._json({key: value}))
+            self._accounts[index]._fields[key] = value
+        self._commit(seq)
+
+    def unset_field_at(self, index: int, key: str) -> None:
+        with self._locks[index]:
+            owner = self._owner_at(index)
+            del self._accounts[index]._fields[key]
+            seq = self._append(_UNSET, owner, lambda: _pack_str(key))
+        self._commit(seq)
+
+    def transfer(self, sender: str, recipient: str, amount: float) -> str:
+        """
+        Transfer an amount between two accounts.
+
+        :param sender: Owner of the account to debit.
+        :param recipient: Owner of the account to credit.
+        :param amount: The amount.
+        :return: "success", "invalid amount" or "insufficient funds".
+        """
+        while True:
+            src, dst = self._index[sender], self._index[recipient]
+            if amount <= 0:
+                return "invalid amount"
+            first, second = sorted((src, dst))
+            second_lock = self._locks[second] if second != first else contextlib.nullcontext()
+            with self._locks[first], second_lock:
+                if self._index.get(sender) != src or self._index.get(recipient) != dst:
+                    continue  # An account was closed or reopened meanwhile.
+                if self._balances[src] < amount:
+                    return "insufficient funds"
+                seq = self._append_transfers(((sender, recipient, amount),))
+                self._balances[src] -= amount
+                self._balances[dst] += amount
+                break
+        self._committed(1)
+        self._commit(seq)
+        return "success"
+
+    def transfer_batch(self, transfers: Sequence[Transfer]) -> str:
+        """
+        Atomically perform a sequence of transfers: either all of them succeed, or none does.
+
+        :param transfers: The transfers, as (sender, recipient, amount) tuples.
+                          Each must be covered by the balance of its sender after the previous ones.
+        :return: "success", "invalid amount" or "insufficient funds".
+        """
+        while True:
+            owners = {o: self._index[o] for s, r, _ in transfers for o in (s, r)}
+            if any(amount <= 0 for _, _, amount in transfers):
+                return "invalid amount"
+            with self._locked(owners.values()):
+                if any(self._index.get(o) != i for o, i in owners.items()):
+                    continue  # An account was closed or reopened meanwhile.
+                balances: dict[int, float] = {}
+                for s, r, amount in transfers:
+                    src, dst = owners[s], owners[r]
+                    src_balance = balances.get(src, self._balances[src])
+                    if src_balance < amount:
+                        return "insufficient funds"
+                    balances[src] = src_balance - amount
+                    balances[dst] = balances.get(dst, self._balances[dst]) + amount
+                seq = self._append_transfers(transfers)
+                for i, balance in balances.items():
+                    self._balances[i] = balance
+                break
+        self._committed(len(transfers))
+        self._commit(seq)
+        return "success"
+
+    def snapshot(self) -> dict[str, float]:
+        """
+        Return the balances of all accounts at a single point in time.
+
+        :return: Balances by owner.
+        """
+        with self._lock, self._locked(range(len(self._locks))):
+            return {owner: self._balances[i] for owner, i in self._index.items()}
+
+    def balances(self, *owners: str) -> dict[str, float]:
+        """
+        Return the balances of some accounts.
+
+        :param owners: Owners of the accounts.
+        :return: Balances by owner.
+        """
+        return {owner: self._balances[self._index[owner]] for owner in owners}
+
+    def _slot(self, owner: str) -> int:
+        # Index of the account of an owner, or of a free slot that `_bind` assigns to it.
+        if (index := self._index.get(owner)) is None:
+            index = self._free.pop() if self._free else self._grow()
+        return index
+
+    def _bind(self, owner: str, index: int) -> None:
+        self._index[owner] = index
+        self._owners[index] = owner
+
+    def _owner_at(self, index: int) -> str:
+        # Called with the lock of the account held, so that it cannot be closed meanwhile.
+        owner = self._owners[index]
+        if self._index.get(owner) != index:
+            err_msg = "The account has been closed"
+            raise KeyError(err_msg)
+        return owner
+
+    def _close(self, owner: str) -> None:
+        index = self._index.pop(owner)
+        self._balances[index] = 0.0
+        self._free.append(index)
+
+    def _grow(self) -> int:
+        index = len(self._balances)
+        self._balances.append(0.0)
+        self._owners.append("")
+        self._accounts.append(Account(self, index, {}))
+        self._locks.append(threading.Lock())
+        return index
+
+    def _replay(self, kind: int, r: _Reader) -> None:
+        # Records were validated before being logged, so they are applied as they are.
+        if kind == _TRANSFER:
+            count = r.count()
+            for _ in range(count):
+                src, dst = self._index[r.str()], self._index[r.str()]
+                amount = r.amount()
+                self._balances[src] -= amount
+                self._balances[dst] += amount
+            self._transactions += count
+            return
+        owner = r.str()
+        if kind == _OPEN:
+            index = self._slot(owner)
+            self._bind(owner, index)
+            self._balances[index] = r.amount()
+            self._accounts[index] = Account(self, index, r.fields())
+        elif kind == _CLOSE:
+            self._close(owner)
+        elif kind == _BALANCE:
+            self._balances[self._index[owner]] = r.amount()
+        elif kind == _FIELD:
+            self[owner]._fields.update(r.fields())
+        elif kind == _UNSET:
+            self[owner]._fields.pop(r.str(), None)
+        else:
+            err_msg = f"Invalid ledger record: {kind}"
+            raise ValueError(err_msg)
+
+    def _json(self, fields: dict[str, Any]) -> bytes:
+        persistent: dict[str, Any] = {}
+        for key, value in fields.items():
+            try:
+                json.dumps({key: value}, cls=BytesAwareJSONEncoder)
+            except (TypeError, ValueError):
+                if key not in self._unpersisted:
+                    self._unpersisted.add(key)
+                    log.warning("[Ledger] Field %r cannot be persisted", key)
+            else:
+                persistent[key] = value
+        return json.dumps(persistent, cls=BytesAwareJSONEncoder).encode()
+
+    def _append(self, kind: int, owner: str, payload: Callable[[], bytes] | None = None) -> int:
+        # Payloads are only encoded if there is a log to append them to.
+        if self._wal is None:
+            return 0
+        data = _pack_str(owner) + (payload() if payload else b"")
+        return self._wal.append(kind, data)
+
+    def _append_transfers(self, transfers: Sequence[Transfer]) -> int:
+        # A batch is logged as a single record, so that it is recovered atomically.
+        if self._wal is None:
+            return 0
+        data = bytearray(_COUNT.pack(len(transfers)))
+        for sender, recipient, amount in transfers:
+            data += _pack_str(sender) + _pack_str(recipient) + _AMOUNT.pack(amount)
+        return self._wal.append(_TRANSFER, bytes(data))
+
+    def _commit(self, seq: int) -> None:
+        if self._wal is not None and self._synchronous:
+            self._wal.wait(seq)
+
+    @contextlib.contextmanager
+    def _locked(self, indexes: Iterable[int]) -> Iterator[None]:
+        # Locks are always acquired in index order, so that concurrent transfers cannot deadlock.
+        with contextlib.ExitStack() as stack:
+            for i in sorted(set(indexes)):
+                stack.enter_context(self._locks[i])
+            yield
+
+    def _committed(self, count: int) -> None:
+        with self._lock:
+            self._transactions += count
+
+
+class LedgerBenchmark(NamedTuple):
+    """Throughput of a ledger backed by a write-ahead log on the current machine."""
+
+    window: float
+    """Durability window of the log, in seconds."""
+    synchronous: bool
+    """Whether transfers waited until they were durable."""
+    threads: int
+    """Number of threads performing transfers concurrently."""
+    transactions: int
+    """Number of transfers performed."""
+    throughput: float
+    """Transfers per second, including the final sync."""
+    syncs: int
+    """Number of syncs of the log."""
+
+
+def benchmark_ledger(
+    window: float = 0.0,
+    *,
+    synchronous: bool = True,
+    threads: int = 8,
+    transactions: int = 10000,
+    accounts: int = 1000,
+    directory: str | Path | None = None,
+) -> LedgerBenchmark:
+    """
+    Measure the transfer throughput of a ledger backed by a write-ahead log.
+
+    :param window: Durability window of the log, in seconds.
+    :param synchronous: Whether transfers wait until they are durable.
+    :param threads: Number of threads performing transfers concurrently.
+    :param transactions: Total number of transfers.
+    :param accounts: Number of accounts.
+    :param directory: Directory of the temporary log. If None, the system default is used.
+    :return: The benchmark results.
+    """
+    with tempfile.TemporaryDirectory(dir=directory) as tmp:
+        path = Path(tmp) / "ledger.wal"
+        with Ledger.open(path, synchronous=False) as ledger:
+            for i in range(accounts):
+                ledger[f"user{i}"] = {Ledger.BALANCE: float(transactions)}
+
+        def run(worker: int) -> None:
+            for i in range(worker, transactions, threads):
+                ledger.transfer(f"user{i % accounts}", f"user{(i * 7 + 1) % accounts}", 1.0)
+
+        with Ledger.open(path, window, synchronous=synchronous) as ledger:
+            assert ledger.wal is not None  # noqa: S101
+            workers = [threading.Thread(target=run, args=(i,)) for i in range(threads)]
+            syncs = ledger.wal.syncs
+            start = time.perf_counter()
+            for w in workers:
+                w.start()
+            for w in workers:
+                w.join()
+            ledger.wal.wait()
+            elapsed = time.perf_counter() - start
+            syncs = ledger.wal.syncs - syncs
+
+    throughput = transactions / elapsed
+    return LedgerBenchmark(window, synchronous, threads, transactions, throughput, syncs)
+
+
+def main(argv: Sequence[str] | None = None) -> None:
+    parser = argparse.ArgumentParser(
+        prog="python -m issp._ledger",
+        description="Benchmark transfers on a ledger backed by a write-ahead log.",
+    )
+    parser.add_argument(
+        "-w",
+        "--window",
+        type=float,
+        nargs="+",
+        default=[0.0, 0.001, 0.01],
+        help="durability windows to try (s)",
+    )
+    parser.add_argument("-t", "--threads", type=int, default=8, help="concurrent threads")
+    parser.add_argument("-n", "--transactions", type=int, default=10000, help="total transfers")
+    parser.add_argument("-a", "--accounts", type=int, default=1000, help="number of accounts")
+    parser.add_argument("-d", "--directory", type=Path, help="directory of the log")
+    parser.add_argument(
+        "--async",
+        dest="synchronous",
+        action="store_false",
+        help="do not wait for durability",
+    )
+    args = parser.parse_args(argv)
+
+    for window in args.window:
+        b = benchmark_ledger(
+            window,
+            synchronous=args.synchronous,
+            threads=args.threads,
+            transactions=args.transactions,
+            accounts=args.accounts,
+            directory=args.directory,
+        )
+        log.info(
+            "[Ledger] window=%gs: %.0f transfers/s, %.1f transfers/sync",
+            b.window,
+            b.throughput,
+            b.transactions / max(b.syncs, 1),
+        )
+
+
+if __name__ == "__main__":
+    main()
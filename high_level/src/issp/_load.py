@@ -0,0 +1,418 @@
+from __future__ import annotations
+
+import argparse
+import heapq
+import itertools
+import math
+import random
+import time
+from collections import Counter
+from typing import TYPE_CHECKING, Any, NamedTuple
+
+from . import _log as log
+from ._comm import Channel, Medium, Message, Plaintext
+from ._server import BankServer, FileServer, Server
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Iterator, Mapping, Sequence
+
+    from ._comm import Layer
+
+type BodyFactory = Callable[[str, random.Random], dict[str, Any]]
+
+
+class Operation(NamedTuple):
+    """A kind of request issued by the clients of a load test."""
+
+    name: str
+    """Name of the operation, used to group its results."""
+    body: BodyFactory
+    """Function returning the body of a request, given the name of the client and an RNG."""
+    weight: float = 1.0
+    """Relative frequency of the operation in the mix."""
+
+
+class LatencyHistogram:
+    """
+    Histogram of latencies with logarithmic buckets.
+
+    .. note::
+        Each power of two of microseconds is split into `SUB_BUCKETS` buckets, so that percentiles
+        are accurate to within about 4% regardless of the magnitude of the latencies.
+    """
+
+    SUB_BUCKETS = 16
+    """Number of buckets per power of two."""
+
+    @property
+    def count(self) -> int:
+        """Number of recorded latencies."""
+        return self._count
+
+    @property
+    def mean(self) -> float:
+        """Mean latency, in seconds."""
+        return self._total / self._count if self._count else 0.0
+
+    @property
+    def min(self) -> float:
+        """Minimum latency, in seconds."""
+        return self._min if self._count else 0.0
+
+    @property
+    def max(self) -> float:
+        """Maximum latency, in seconds."""
+        return self._max
+
+    def __init__(self) -> None:
+        self._buckets: Counter[int] = Counter()
+        self._count = 0
+        self._total = 0.0
+        self._min = math.inf
+        self._max = 0.0
+
+    def record(self, latency: float) -> None:
+        """
+        Record a latency.
+
+        :param latency: The latency, in seconds.
+        """
+        micros = latency * 1e6
+        self._buckets[int(math.log2(micros) * self.SUB_BUCKETS) if micros > 1.0 else 0] += 1
+        self._count += 1
+        self._total += latency
+        self._min = min(self._min, latency)
+        self._max = max(self._max, latency)
+
+    def percentile(self, p: float) -> float:
+        """
+        Return a percentile of the recorded latencies.
+
+        :param p: The percentile, between 0 and 100.
+        :return: Upper bound of the bucket containing the percentile, in seconds.
+        """
+        rank = max(math.ceil(p / 100.0 * self._count), 1)
+        for upper, count in self.buckets():
+            rank -= count
+            if rank <= 0:
+                return min(upper, self._max)
+        return self._max
+
+    def buckets(self) -> Iterator[tuple[float, int]]:
+        """
+        Iterate over the non-empty buckets, in increasing order of latency.
+
+        :return: Iterator over the (upper bound in seconds, count) pairs.
+        """
+        for bucket in sorted(self._buckets):
+            yield 2.0 ** ((bucket + 1) / self.SUB_BUCKETS) / 1e6, self._buckets[bucket]
+
+    def __repr__(self) -> str:
+        p50, p99 = self.percentile(50.0) * 1e3, self.percentile(99.0) * 1e3
+        return f"LatencyHistogram(count={self._count}, p50={p50:.3f}ms, p99={p99:.3f}ms)"
+
+
+class OperationStats(NamedTuple):
+    """Results of the requests of an operation."""
+
+    statuses: Counter[str]
+    """Number of responses with each status."""
+    latency: LatencyHistogram
+    """Response times of the requests."""
+
+    @property
+    def requests(self) -> int:
+        """Number of completed requests."""
+        return self.statuses.total()
+
+    @property
+    def errors(self) -> int:
+        """Number of requests whose status was not "success"."""
+        return self.requests - self.statuses["success"]
+
+
+class LoadReport(NamedTuple):
+    """Results of a load test."""
+
+    clients: int
+    """Number of clients."""
+    rate: float | None
+    """Target request rate of an open-loop test, or None for a closed-loop test."""
+    duration: float
+    """Time between the first request and the last response, in seconds."""
+    latency: LatencyHistogram
+    """Response times, from the scheduled arrival of each request to its response."""
+    service: LatencyHistogram
+    """Time spent by the server on each request, excluding queueing."""
+    operations: dict[str, OperationStats]
+    """Results of each operation."""
+
+    @property
+    def requests(self) -> int:
+        """Number of completed requests."""
+        return self.latency.count
+
+    @property
+    def errors(self) -> int:
+        """Number of requests whose status was not "success"."""
+        return sum(op.errors for op in self.operations.values())
+
+    @property
+    def error_rate(self) -> float:
+        """Fraction of requests whose status was not "success"."""
+        return self.errors / self.requests if self.requests else 0.0
+
+    @property
+    def throughput(self) -> float:
+        """Completed requests per second."""
+        return self.requests / self.duration if self.duration else 0.0
+
+    @property
+    def capacity(self) -> float:
+        """Requests per second the server would complete if it never waited for requests."""
+        total = self.service.mean * self.service.count
+        return self.requests / total if total else 0.0
+
+
+class _Load:
+    # Drives a server on the current thread, exactly as its `listen` loop would: one request
+    # at a time, in order of arrival.
+
+    def __init__(
+        self,
+        server: Server,
+        mix: Sequence[Operation],
+        clients: int,
+        stacks: Mapping[str, Layer] | Callable[[str], Layer] | None,
+        seed: int | None,
+    ) -> None:
+        if not mix:
+            err_msg = "The operation mix is empty"
+            raise ValueError(err_msg)
+        self.server = server
+        self.mix = mix
+        self.weights = list(itertools.accumulate(op.weight for op in mix))
+        self.rng = random.Random(seed)  # noqa: S311
+        self.clients = [f"Client{i}" for i in range(clients)]
+        if stacks is None:
+            stacks = {c: server.channels.get(c, server.plain).stack for c in self.clients}
+        self.stacks: dict[str, Layer] = {
+            c: stacks(c) if callable(stacks) else stacks[c] for c in self.clients
+        }
+        self.latency = LatencyHistogram()
+        self.service = LatencyHistogram()
+        self.operations = {op.name: OperationStats(Counter(), LatencyHistogram()) for op in mix}
+
+    def request(self, client: str, body: dict[str, Any]) -> tuple[str, float]:
+        stack = self.stacks[client]
+        msg = stack.encode(Message(client, self.server.name, body))
+        start = time.perf_counter()
+        try:
+            response = self.server.process(msg)
+        except Exception as e:
+            return type(e).__name__, time.perf_counter() - start
+        elapsed = time.perf_counter() - start
+        try:
+            status = str(stack.decode(response).json_dict().get("status"))
+        except Exception as e:
+            status = type(e).__name__
+        return status, elapsed
+
+    def issue(self, client: str, arrival: float) -> float:
+        op = self.rng.choices(self.mix, cum_weights=self.weights)[0]
+        body = op.body(client, self.rng)
+        if (delay := arrival - time.perf_counter()) > 0.0:
+            time.sleep(delay)
+        status, service = self.request(client, body)
+        done = time.perf_counter()
+        self.service.record(service)
+        self.latency.record(done - arrival)
+        stats = self.operations[op.name]
+        stats.statuses[status] += 1
+        stats.latency.record(done - arrival)
+        return done
+
+
+def generate_load(
+    server: Server,
+    mix: Sequence[Operation],
+    *,
+    clients: int = 16,
+    stacks: Mapping[str, Layer] | Callable[[str], Layer] | None = None,
+    rate: float | None = None,
+    think_time: float = 0.0,
+    duration: float = 5.0,
+    requests: int | None = None,
+    setup: BodyFactory | None = None,
+    seed: int | None = None,
+) -> LoadReport:
+    """
+    Measure the latency and throughput of a server under a synthetic load.
+
+    .. note::
+        Requests are encoded and decoded with the stack of each client, and handled through
+        `Server.process`, bypassing the medium. By default, clients use the stacks of the server
+        channels, which only works for symmetric layers: layers with per-party keys, such as
+        `Envelope`, `Signature` or `SessionEnvelope`, need separate client stacks. Requests are
+        handled one at a time, as in `Server.listen`, so response times include the time requests
+        spend waiting for the server.
+
+        In closed-loop tests (the default), each client issues a request, waits for the response,
+        then waits `think_time` before issuing the next one: with no think time, the server never
+        waits for requests, although the throughput still includes the time the clients spend
+        encoding requests and decoding responses, which `LoadReport.capacity` excludes. In
+        open-loop tests, requests arrive at `rate` per second regardless of the responses,
+        following a Poisson process, so that response times grow without bound past capacity.
+
+    :param server: The server.
+    :param mix: Operations issued by the clients, chosen at random according to their weights.
+    :param clients: Number of clients, named "Client0", "Client1", and so on.
+    :param stacks: Stack of each client, as a mapping from client names or a function of them.
+                   If None, clients use the stacks of the server channels.
+    :param rate: Requests per second of an open-loop test. If None, the test is closed-loop.
+    :param think_time: Time between a response and the next request of a client, in seconds.
+    :param duration: Maximum time during which requests are issued, in seconds.
+    :param requests: Maximum number of requests. If None, only `duration` is considered.
+    :param setup: Body of a request issued once by each client before the test, e.g. to register.
+    :param seed: Seed of the random choices. If None, the system default is used.
+    :return: The test results.
+    """
+    load = _Load(server, mix, clients, stacks, seed)
+    if setup is not None:
+        for client in load.clients:
+            load.request(client, setup(client, load.rng))
+
+    limit = math.inf if requests is None else requests
+    start = time.perf_counter()
+    end = start + duration
+    done = start
+    count = 0
+
+    if rate is None:
+        ready = [(start, i) for i in range(clients)]
+        while ready and count < limit:
+            arrival, i = heapq.heappop(ready)
+            if arrival >= end:
+                break
+            done = load.issue(load.clients[i], arrival)
+            heapq.heappush(ready, (done + think_time, i))
+            count += 1
+    else:
+        arrival = start
+        while count < limit and (arrival := arrival + load.rng.expovariate(rate)) < end:
+            done = load.issue(load.rng.choice(load.clients), arrival)
+            count += 1
+
+    return LoadReport(clients, rate, done - start, load.latency, load.service, load.operations)
+
+
+class _BenchBankServer(BankServer):
+    def register(self, sender: str, body: dict[str, Any]) -> bool:
+        self.db[sender] = {"balance": body["balance"]}
+        return True
+
+    def authenticate(self, sender: str, body: dict[str, Any]) -> bool:
+        del sender, body  # Unused
+        return True
+
+
+class _BenchFileServer(FileServer):
+    def authorize(self, sender: str, body: dict[str, Any]) -> bool:
+        del sender, body  # Unused
+        return True
+
+
+def _workload(
+    name: str,
+    clients: int,
+    medium: Medium,
+) -> tuple[Server, Sequence[Operation], BodyFactory | None]:
+    channel = Channel("Server", medium, Plaintext())
+
+    def peer(rng: random.Random) -> dict[str, Any]:
+        return {"recipient": f"Client{rng.randrange(clients)}", "amount": 1}
+
+    def transfer(_: str, rng: random.Random) -> dict[str, Any]:
+        return {"action": "perform_transaction"} | peer(rng)
+
+    def transfer_batch(_: str, rng: random.Random) -> dict[str, Any]:
+        return {"action": "perform_transactions", "transactions": [peer(rng) for _ in range(10)]}
+
+    def register(_: str, __: random.Random) -> dict[str, Any]:
+        return {"action": "register", "balance": 1e9}
+
+    if name == "bank":
+        ops = (
+            Operation("perform_transaction", transfer, 9.0),
+            Operation("perform_transactions", transfer_batch),
+        )
+        return _BenchBankServer("Server", channel), ops, register
+
+    server = _BenchFileServer("Server", channel)
+    server.files = {"log.txt": ""}
+
+    def write(client: str, _: random.Random) -> dict[str, Any]:
+        return {"action": "write", "path": "log.txt", "data": f"Written by {client}.\n"}
+
+    def read(_: str, rng: random.Random) -> dict[str, Any]:
+        offset = rng.randrange(server.files.size("log.txt") + 1)
+        return {"action": "read", "path": "log.txt", "offset": offset, "length": 256}
+
+    return server, (Operation("write", write, 4.0), Operation("read", read)), None
+
+
+def _describe(report: LoadReport) -> str:
+    mode = "closed loop" if report.rate is None else f"open loop at {report.rate:.0f} req/s"
+    return (
+        f"{mode}: {report.throughput:.0f} req/s (capacity {report.capacity:.0f} req/s), "
+        f"latency p50={report.latency.percentile(50.0) * 1e3:.3f}ms "
+        f"p99={report.latency.percentile(99.0) * 1e3:.3f}ms "
+        f"max={report.latency.max * 1e3:.3f}ms, errors={report.error_rate:.2%}"
+    )
+
+
+def main(argv: Sequence[str] | None = None) -> None:
+    parser = argparse.ArgumentParser(
+        prog="python -m issp._load",
+        description="Measure the latency and throughput of a server under a synthetic load.",
+    )
+    parser.add_argument("server", choices=("bank", "file"), help="server to load")
+    parser.add_argument("-c", "--clients", type=int, default=16, help="number of clients")
+    parser.add_argument("-d", "--duration", type=float, default=2.0, help="duration of each test")
+    parser.add_argument(
+        "-l",
+        "--load",
+        type=float,
+        nargs="+",
+        default=[0.5, 0.8, 0.95],
+        help="open-loop rates to try, as fractions of the server capacity",
+    )
+    parser.add_argument("-s", "--seed", type=int, help="seed of the random choices")
+    args = parser.parse_args(argv)
+    medium = Medium()
+
+    def run(rate: float | None) -> LoadReport:
+        server, ops, setup = _workload(args.server, args.clients, medium)
+        level = log.get_level()
+        log.set_level(max(level, log.WARNING))
+        try:
+            return generate_load(
+                server,
+                ops,
+                clients=args.clients,
+                rate=rate,
+                duration=args.duration,
+                setup=setup,
+                seed=args.seed,
+            )
+        finally:
+            log.set_level(level)
+
+    closed_loop = run(None)
+    log.info("[Load] %s", _describe(closed_loop))
+    for load in args.load:
+        log.info("[Load] %s", _describe(run(closed_loop.capacity * load)))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,37 +1,227 @@
 from __future__ import annotations
 
+import atexit
+import copy
 import functools
 import logging
+import queue
+import struct
 import sys
+import threading
+import time
 from logging import CRITICAL, DEBUG, ERROR, INFO, WARNING
+from logging.handlers import QueueHandler
 from time import perf_counter_ns as tick
-from typing import TYPE_CHECKING
+from typing import TYPE_CHECKING, NamedTuple
 
 if TYPE_CHECKING:
     from collections.abc import Callable, Collection, Iterable, Iterator
-    from typing import Any
+    from pathlib import Path
+    from typing import Any, BinaryIO
 
 
 _LOGGER = logging.getLogger("issp")
+_HANDLER = logging.StreamHandler(sys.stdout)
 
 
 def _setup_logger() -> None:
     logging.addLevelName(WARNING, "WARN")
     fmt = "[%(asctime)s] [%(name)s] [%(levelname)-5s] %(message)s"
     datefmt = "%Y-%m-%d %H:%M:%S"
-    handler = logging.StreamHandler(sys.stdout)
-    handler.setFormatter(logging.Formatter(fmt, datefmt=datefmt))
-    _LOGGER.addHandler(handler)
+    _HANDLER.setFormatter(logging.Formatter(fmt, datefmt=datefmt))
+    _LOGGER.addHandler(_HANDLER)
     _LOGGER.setLevel(logging.INFO)
 
 
 _setup_logger()
 
 
+def _source(record: logging.LogRecord) -> str:
+    # Log messages are conventionally prefixed by "[source]", either literal or as the first arg.
+    msg = str(record.msg)
+    if msg.startswith("[%s]") and isinstance(record.args, tuple) and record.args:
+        return str(record.args[0])
+    if msg.startswith("[") and (end := msg.find("]")) > 0:
+        return msg[1:end]
+    return record.module
+
+
+class _RateLimitFilter(logging.Filter):
+    def __init__(self, rate: float, burst: int) -> None:
+        super().__init__()
+        self._rate = rate
+        self._burst = float(burst)
+        self._buckets: dict[str, tuple[float, float, int]] = {}
+        self._lock = threading.Lock()
+
+    def filter(self, record: logging.LogRecord) -> bool | logging.LogRecord:
+        source = _source(record)
+        now = time.monotonic()
+        with self._lock:
+            tokens, last, dropped = self._buckets.get(source, (self._burst, now, 0))
+            tokens = min(self._burst, tokens + (now - last) * self._rate)
+            if tokens < 1.0:
+                self._buckets[source] = (tokens, now, dropped + 1)
+                return False
+            self._buckets[source] = (tokens - 1.0, now, 0)
+        if not dropped:
+            return True
+        record = copy.copy(record)
+        record.msg = f"{record.msg} (%d records suppressed)"
+        record.args = (*record.args, dropped) if isinstance(record.args, tuple) else (dropped,)
+        return record
+
+
+class _SnapshotQueueHandler(QueueHandler):
+    _IMMUTABLE = (str, int, float, bytes, bool, type(None))
+
+    def prepare(self, record: logging.LogRecord) -> logging.LogRecord:
+        # Formatting is deferred to the writer thread, so only a shallow snapshot of the
+        # arguments is taken here, in case the caller later rebinds their attributes.
+        if isinstance(record.args, tuple):
+            record.args = tuple(
+                a if isinstance(a, self._IMMUTABLE) else _snapshot(a) for a in record.args
+            )
+        return record
+
+
+def _snapshot(obj: object) -> object:
+    try:
+        return copy.copy(obj)
+    except Exception:
+        return str(obj)
+
+
+class BinaryRecord(NamedTuple):
+    timestamp: float
+    level: int
+    source: str
+    message: str
+
+
+_BINARY_HEADER = struct.Struct("<QBHI")
+
+
+def _write_binary(stream: BinaryIO, record: logging.LogRecord) -> None:
+    source = _source(record).encode(errors="replace")[:0xFFFF]
+    message = record.getMessage().encode(errors="replace")
+    header = (int(record.created * 10**9), record.levelno, len(source), len(message))
+    stream.write(_BINARY_HEADER.pack(*header) + source + message)
+
+
+def read_binary(path: str | Path) -> Iterator[BinaryRecord]:
+    with open(path, "rb") as f:  # noqa: PTH123
+        while header := f.read(_BINARY_HEADER.size):
+            ns, level, source_len, message_len = _BINARY_HEADER.unpack(header)
+            source = f.read(source_len).decode(errors="replace")
+            message = f.read(message_len).decode(errors="replace")
+            yield BinaryRecord(ns / 10**9, level, source, message)
+
+
+class _AsyncWriter:
+    def __init__(self, batch_size: int, binary: BinaryIO | None) -> None:
+        self.queue: queue.SimpleQueue[logging.LogRecord | None] = queue.SimpleQueue()
+        self._batch_size = batch_size
+        self._binary = binary
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+
+    def _write(self, record: logging.LogRecord) -> None:
+        try:
+            if self._binary:
+                _write_binary(self._binary, record)
+            else:
+                _HANDLER.stream.write(_HANDLER.format(record) + _HANDLER.terminator)
+        except Exception:
+            _HANDLER.handleError(record)
+
+    def _run(self) -> None:
+        # Records are flushed once the queue is drained or a batch is full.
+        running = True
+        while running:
+            batch = [self.queue.get()]
+            while len(batch) < self._batch_size:
+                try:
+                    batch.append(self.queue.get_nowait())
+                except queue.Empty:
+                    break
+            for record in batch:
+                if record is None:
+                    running = False
+                    break
+                self._write(record)
+            (self._binary or _HANDLER.stream).flush()
+
+    def stop(self) -> None:
+        self.queue.put(None)
+        self._thread.join()
+        if self._binary:
+            self._binary.close()
+
+
+_ASYNC: tuple[_AsyncWriter, QueueHandler] | None = None
+
+
+def enable_async(
+    *,
+    batch_size: int = 256,
+    binary_path: str | Path | None = None,
+) -> None:
+    """
+    Log through a queue drained by a dedicated writer thread.
+
+    :param batch_size: Maximum number of records written between flushes.
+    :param binary_path: If set, records are written to this file in binary form
+                        instead of to stdout. Use `read_binary` to decode them.
+    """
+    disable_async()
+    global _ASYNC  # noqa: PLW0603
+    binary = open(binary_path, "ab") if binary_path else None  # noqa: PTH123, SIM115
+    writer = _AsyncWriter(max(1, batch_size), binary)
+    handler = _SnapshotQueueHandler(writer.queue)  # pyright: ignore[reportArgumentType]
+    _LOGGER.removeHandler(_HANDLER)
+    _LOGGER.addHandler(handler)
+    _ASYNC = (writer, handler)
+
+
+def disable_async() -> None:
+    global _ASYNC  # noqa: PLW0603
+    if _ASYNC is None:
+        return
+    writer, handler = _ASYNC
+    _ASYNC = None
+    _LOGGER.removeHandler(handler)
+    _LOGGER.addHandler(_HANDLER)
+    writer.stop()
+
+
+atexit.register(disable_async)
+
+
+def set_rate_limit(rate: float | None, burst: int = 10) -> None:
+    """
+    Limit the number of records logged per second by each source.
+
+    Sources are identified by the bracketed prefix of the message, e.g. the channel name.
+
+    :param rate: Sustained records per second per source. If None, disables rate limiting.
+    :param burst: Number of records a source can log in a burst.
+    """
+    for f in _LOGGER.filters:
+        if isinstance(f, _RateLimitFilter):
+            _LOGGER.removeFilter(f)
+    if rate is not None:
+        _LOGGER.addFilter(_RateLimitFilter(rate, burst))
+
+
 def _int_level(level: int | str) -> int:
     return level if isinstance(level, int) else int(getattr(logging, level.upper()))
 
 
+def get_level() -> int:
+    return _LOGGER.getEffectiveLevel()
+
+
 def set_level(level: int | str) -> None:
     _LOGGER.setLevel(level)
 
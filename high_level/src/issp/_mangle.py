@@ -0,0 +1,204 @@
+from __future__ import annotations
+
+import itertools
+import operator
+import string
+from typing import TYPE_CHECKING
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Iterable, Iterator
+
+    type _Op = Callable[[Iterable[bytes]], Iterable[bytes]]
+
+
+def _position(symbol: str) -> int:
+    # Hashcat encodes positions as 0-9, then A-Z for 10-35.
+    if symbol.isdigit():
+        return int(symbol)
+    if symbol.isupper():
+        return ord(symbol) - ord("A") + 10
+    err_msg = f"Invalid position: {symbol!r}"
+    raise ValueError(err_msg)
+
+
+def _toggle_at(pos: int) -> Callable[[bytes], bytes]:
+    def toggle(word: bytes) -> bytes:
+        if pos >= len(word):
+            return word
+        return word[:pos] + word[pos : pos + 1].swapcase() + word[pos + 1 :]
+
+    return toggle
+
+
+def _delete_at(pos: int) -> Callable[[bytes], bytes]:
+    def delete(word: bytes) -> bytes:
+        return word[:pos] + word[pos + 1 :]
+
+    return delete
+
+
+def _invert_capitalize(word: bytes) -> bytes:
+    return word[:1].lower() + word[1:].upper()
+
+
+def _mapped(fn: Callable[..., bytes], *args: object) -> _Op:
+    if not args:
+        return lambda words: map(fn, words)
+    return lambda words: map(fn, words, *(itertools.repeat(a) for a in args))
+
+
+_FUNCTIONS: dict[str, _Op] = {
+    "l": _mapped(bytes.lower),
+    "u": _mapped(bytes.upper),
+    "c": _mapped(bytes.capitalize),
+    "C": _mapped(_invert_capitalize),
+    "t": _mapped(bytes.swapcase),
+    "r": _mapped(operator.getitem, slice(None, None, -1)),
+    "d": _mapped(operator.mul, 2),
+    "f": lambda words: (w + w[::-1] for w in words),
+}
+
+_FUNCTIONS_WITH_ARGS: dict[str, tuple[int, Callable[..., _Op]]] = {
+    "T": (1, lambda n: _mapped(_toggle_at(_position(n)))),
+    "$": (1, lambda c: _mapped(operator.add, c.encode())),
+    "^": (1, lambda c: _mapped(c.encode().__add__)),
+    "s": (2, lambda x, y: _mapped(bytes.translate, bytes.maketrans(x.encode(), y.encode()))),
+    "D": (1, lambda n: _mapped(_delete_at(_position(n)))),
+    "'": (1, lambda n: _mapped(operator.getitem, slice(_position(n)))),
+}
+
+
+def _compile(program: str) -> list[_Op]:
+    ops: list[_Op] = []
+    symbols = iter(program)
+    for cmd in symbols:
+        if cmd in " :":
+            continue
+        if op := _FUNCTIONS.get(cmd):
+            ops.append(op)
+            continue
+        if cmd not in _FUNCTIONS_WITH_ARGS:
+            err_msg = f"Unknown rule function: {cmd!r}"
+            raise ValueError(err_msg)
+        arity, factory = _FUNCTIONS_WITH_ARGS[cmd]
+        args = [next(symbols, None) for _ in range(arity)]
+        if None in args:
+            err_msg = f"Missing argument for rule function {cmd!r} in {program!r}"
+            raise ValueError(err_msg)
+        ops.append(factory(*args))
+    return ops
+
+
+class Rule:
+    """
+    A word mangling rule, written in a subset of the hashcat rule syntax.
+
+    Supported functions:
+
+    - ``:`` does nothing.
+    - ``l``, ``u``, ``c``, ``C``, ``t`` lowercase, uppercase, capitalize, invert-capitalize,
+      and toggle the case of the whole word.
+    - ``TN`` toggles the case of the character at position N.
+    - ``r``, ``d``, ``f`` reverse, duplicate, and reflect the word.
+    - ``$X``, ``^X`` append and prepend the character X.
+    - ``sXY`` replaces every occurrence of X with Y.
+    - ``DN`` deletes the character at position N, ``'N`` truncates the word to N characters.
+
+    Positions are 0-9, then A-Z for 10-35.
+    """
+
+    def __init__(self, program: str) -> None:
+        """
+        Compile a rule.
+
+        :param program: The rule program, e.g. ``"c $1 $2 $3"``.
+        """
+        self.program = program
+        """The rule program."""
+        self._ops = _compile(program)
+
+    def __repr__(self) -> str:
+        return f"Rule({self.program!r})"
+
+    def __call__(self, word: bytes) -> bytes:
+        return self.apply((word,))[0]
+
+    def apply(self, words: Iterable[bytes]) -> list[bytes]:
+        """
+        Apply the rule to a batch of words.
+
+        Each function of the rule is applied to the whole batch at once.
+
+        :param words: The words to mangle.
+        :return: The mangled words.
+        """
+        for op in self._ops:
+            words = op(words)
+        return list(words)
+
+
+LEET_RULE = "sa4se3si1so0ss5st7"
+"""Rule program performing common leetspeak substitutions."""
+
+DEFAULT_RULES = (
+    ":",
+    "l",
+    "u",
+    "c",
+    "C",
+    "t",
+    "r",
+    "d",
+    "f",
+    "c r",
+    LEET_RULE,
+    f"c {LEET_RULE}",
+    *(f"${d}" for d in string.digits),
+    *(f"^{d}" for d in string.digits),
+    *(f"c ${d}" for d in string.digits),
+    *(f"${a}${b}" for a, b in itertools.product(string.digits, repeat=2)),
+    "$1$2$3",
+    "c $1$2$3",
+    "$!",
+    "c $!",
+    "$1$!",
+    "c $1$!",
+)
+"""A small set of rule programs covering the most common password mangling patterns."""
+
+
+def mangle_batches(
+    words: Iterable[str | bytes],
+    rules: Iterable[Rule | str] = DEFAULT_RULES,
+    batch_size: int = 2**14,
+) -> Iterator[list[bytes]]:
+    """
+    Apply mangling rules to a wordlist, yielding candidates in batches.
+
+    Words are read in chunks of `batch_size`, and every rule is applied to each chunk,
+    so each yielded batch contains the candidates produced by one rule.
+
+    :param words: The base words.
+    :param rules: The rules to apply, either compiled or as rule programs.
+    :param batch_size: Number of base words per batch.
+    :return: An iterator of candidate batches.
+    """
+    compiled = [r if isinstance(r, Rule) else Rule(r) for r in rules]
+    encoded = (w.encode() if isinstance(w, str) else w for w in words)
+    while chunk := list(itertools.islice(encoded, batch_size)):
+        for rule in compiled:
+            yield rule.apply(chunk)
+
+
+def mangle(
+    words: Iterable[str | bytes],
+    rules: Iterable[Rule | str] = DEFAULT_RULES,
+) -> Iterator[bytes]:
+    """
+    Apply mangling rules to a wordlist.
+
+    :param words: The base words.
+    :param rules: The rules to apply, either compiled or as rule programs.
+    :return: An iterator of candidates.
+    """
+    return itertools.chain.from_iterable(mangle_batches(words, rules))
@@ -0,0 +1,173 @@
+from __future__ import annotations
+
+import functools
+import math
+from collections import Counter
+from typing import TYPE_CHECKING
+
+from ._pass import common_passwords
+
+if TYPE_CHECKING:
+    from collections.abc import Iterable, Iterator, Sequence
+
+
+type _Buckets = list[list[bytes]]
+
+
+class MarkovModel:
+    """
+    Per-position Markov model of password characters.
+
+    .. note::
+        The model estimates the probability of the first character, of each character given the
+        previous one and its position, and of the password length. Probabilities are bucketed
+        into integer levels, where each level halves the probability, and candidates are
+        enumerated by increasing total level, i.e. roughly by decreasing probability.
+    """
+
+    @classmethod
+    @functools.cache
+    def default(cls) -> MarkovModel:
+        """
+        Return a model trained on the bundled list of common passwords.
+
+        :return: The model.
+        """
+        return cls(common_passwords())
+
+    def __init__(
+        self,
+        words: Iterable[str | bytes],
+        levels: int = 10,
+        positions: int = 8,
+        smoothing: float = 0.01,
+    ) -> None:
+        """
+        Train the model.
+
+        :param words: The training words.
+        :param levels: Number of probability levels. Less likely events share the last level.
+        :param positions: Number of positions with their own transition table. Positions past
+                          the last one share its table.
+        :param smoothing: Additive smoothing applied to all counts.
+        """
+        encoded = [w.encode() if isinstance(w, str) else w for w in words]
+        self._levels = levels
+        self._smoothing = smoothing
+        self._alphabet = sorted({c for w in encoded for c in w})
+        self._length_counts = Counter(len(w) for w in encoded)
+        self._length_total = len(encoded)
+
+        initial = Counter(w[0] for w in encoded if w)
+        transitions = [[Counter[int]() for _ in range(256)] for _ in range(max(1, positions - 1))]
+        for w in encoded:
+            for i in range(1, len(w)):
+                transitions[min(i, positions - 1) - 1][w[i - 1]][w[i]] += 1
+
+        self._initial = self._to_buckets(initial)
+        self._transitions = [
+            {c: self._to_buckets(t[c]) for c in self._alphabet} for t in transitions
+        ]
+        self._min_levels = [
+            _min_level(self._initial),
+            *(min(map(_min_level, t.values()), default=0) for t in self._transitions),
+        ]
+        self._min_rest_cache: dict[tuple[int, int], int] = {}
+
+    def _level(self, count: float, total: float) -> int:
+        p = (count + self._smoothing) / (total + self._smoothing * len(self._alphabet))
+        return min(self._levels - 1, int(-math.log2(p)))
+
+    def _to_buckets(self, counts: Counter[int]) -> _Buckets:
+        total = counts.total()
+        buckets: _Buckets = [[] for _ in range(self._levels)]
+        for c in self._alphabet:
+            buckets[self._level(counts[c], total)].append(bytes((c,)))
+        return buckets
+
+    def _table(self, position: int) -> dict[int, _Buckets]:
+        return self._transitions[min(position, len(self._transitions)) - 1]
+
+    def _min_rest(self, position: int, length: int) -> int:
+        if (value := self._min_rest_cache.get((position, length))) is None:
+            last = len(self._min_levels) - 1
+            value = sum(self._min_levels[min(i, last)] for i in range(position, length))
+            self._min_rest_cache[position, length] = value
+        return value
+
+    def length_level(self, length: int) -> int:
+        """
+        Return the level of the given password length.
+
+        :param length: The password length.
+        :return: The level.
+        """
+        return self._level(self._length_counts[length], self._length_total)
+
+    def level(self, candidate: str | bytes) -> int:
+        """
+        Return the total level of a candidate. Lower levels are more likely.
+
+        :param candidate: The candidate.
+        :return: The level.
+        """
+        candidate = candidate.encode() if isinstance(candidate, str) else candidate
+        level = self.length_level(len(candidate))
+        buckets = self._initial
+        for i, c in enumerate(candidate):
+            if i:
+                buckets = self._table(i).get(candidate[i - 1], [])
+            char = bytes((c,))
+            level += next((l for l, b in enumerate(buckets) if char in b), self._levels - 1)
+        return level
+
+    def candidates(
+        self,
+        lengths: int | Sequence[int] = range(1, 13),
+        max_level: int | None = None,
+    ) -> Iterator[bytes]:
+        """
+        Enumerate candidates by increasing level.
+
+        :param lengths: Length or lengths of the candidates.
+        :param max_level: Maximum total level. If None, all candidates are eventually produced.
+        :return: An iterator of candidates.
+        """
+        lengths = (lengths,) if isinstance(lengths, int) else lengths
+        offsets = {l: self.length_level(l) for l in lengths if l > 0}
+        top = max((o + l * (self._levels - 1) for l, o in offsets.items()), default=-1)
+        top = top if max_level is None else min(top, max_level)
+        for level in range(top + 1):
+            for length, offset in offsets.items():
+                if (rest := level - offset) >= self._min_rest(0, length):
+                    yield from self._extend(b"", self._initial, 0, length, rest)
+
+    def _extend(
+        self,
+        prefix: bytes,
+        buckets: _Buckets,
+        position: int,
+        length: int,
+        rest: int,
+    ) -> Iterator[bytes]:
+        if position == length - 1:
+            if rest < self._levels:
+                yield from map(prefix.__add__, buckets[rest])
+            return
+        remaining = length - position - 1
+        lo = max(0, rest - remaining * (self._levels - 1))
+        hi = min(self._levels - 1, rest - self._min_rest(position + 1, length))
+        table = self._table(position + 1)
+        for level in range(lo, hi + 1):
+            for char in buckets[level]:
+                yield from self._extend(
+                    prefix + char,
+                    table[char[0]],
+                    position + 1,
+                    length,
+                    rest - level,
+                )
+
+
+def _min_level(buckets: _Buckets) -> int:
+    return next((i for i, b in enumerate(buckets) if b), len(buckets) - 1)
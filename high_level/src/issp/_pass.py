@@ -36,24 +36,20 @@ def random_common_password(length: int = 5, charset: str = string.ascii_lowercas
     return random_choice(pwds)
 
 
-def generate_password_database(
+def generate_passwords(
     length: int,
     random_ratio: float = 0.5,
     random_min_length: int = 8,
     random_max_length: int = 16,
-    hash_function: Callable[[bytes, bytes | None], bytes] | None = scrypt,
-    salt_length: int = 16,
-) -> dict[int, dict[str, bytes]]:
+) -> list[str]:
     """
-    Generate a password database with a mix of random and common passwords.
+    Generate a shuffled mix of random and common passwords.
 
     :param length: Total number of passwords to generate.
     :param random_ratio: Ratio of random passwords to total passwords.
     :param random_min_length: Minimum length of random passwords.
     :param random_max_length: Maximum length of random passwords.
-    :param hash_function: Hash function to use for password hashing.
-    :param salt_length: Length of the salt to use for hashing.
-    :return: A dictionary mapping user IDs to password data.
+    :return: The passwords.
     """
     common = common_passwords()
     repeat_common = length // len(common) + 1
@@ -67,7 +63,29 @@ def generate_password_database(
     ]
     passwords.extend(random.sample(common, counts=[repeat_common] * len(common), k=common_count))
     random.shuffle(passwords)
+    return passwords
+
+
+def generate_password_database(
+    length: int,
+    random_ratio: float = 0.5,
+    random_min_length: int = 8,
+    random_max_length: int = 16,
+    hash_function: Callable[[bytes, bytes | None], bytes] | None = scrypt,
+    salt_length: int = 16,
+) -> dict[int, dict[str, bytes]]:
+    """
+    Generate a password database with a mix of random and common passwords.
 
+    :param length: Total number of passwords to generate.
+    :param random_ratio: Ratio of random passwords to total passwords.
+    :param random_min_length: Minimum length of random passwords.
+    :param random_max_length: Maximum length of random passwords.
+    :param hash_function: Hash function to use for password hashing.
+    :param salt_length: Length of the salt to use for hashing.
+    :return: A dictionary mapping user IDs to password data.
+    """
+    passwords = generate_passwords(length, random_ratio, random_min_length, random_max_length)
     pass_dict: dict[int, dict[str, bytes]] = {
         i: {"password": password.encode()} for i, password in enumerate(passwords)
     }
@@ -76,7 +94,7 @@ def generate_password_database(
         log.info("Generating password database...")
         for data in log.percent(pass_dict.values()):
             if salt_length > 0:
-                salt = os.urandom(16)
+                salt = os.urandom(salt_length)
                 data["salt"] = salt
             else:
                 salt = None
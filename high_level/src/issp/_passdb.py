@@ -0,0 +1,320 @@
+from __future__ import annotations
+
+import mmap
+import struct
+from array import array
+from collections.abc import Mapping
+from pathlib import Path
+from typing import TYPE_CHECKING, Self
+
+from . import _log as log
+from ._pass import generate_passwords
+from ._rng import random_bytes
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Iterable, Iterator
+    from types import TracebackType
+
+
+_MAGIC = b"ISSPPWDB"
+_VERSION = 1
+# Magic, version, flags, user count, salt size, hash size, plaintext heap size.
+_HEADER = struct.Struct("<8sHHQHHxxxxQ")
+_FLAG_PLAINTEXTS = 1
+_ALIGNMENT = 8
+
+
+def _aligned(size: int) -> int:
+    return -(-size // _ALIGNMENT) * _ALIGNMENT
+
+
+class PasswordDatabase(Mapping[int, dict[str, bytes]]):
+    """
+    Columnar password database.
+
+    .. note::
+        Salts and hashes are stored in fixed-width columns, each in a single contiguous buffer,
+        and plaintexts in a byte heap indexed by an offsets column. Databases can be saved to
+        a file and memory-mapped back, so that cracking engines can scan the columns without
+        copying them. The database also behaves as a read-only mapping from user IDs to records,
+        like the dictionaries returned by `generate_password_database`.
+
+    The file layout is a fixed header followed by the salt, hash, offsets and heap sections,
+    each aligned to 8 bytes.
+    """
+
+    @property
+    def salt_size(self) -> int:
+        """Size of each salt, in bytes. Zero if passwords are unsalted."""
+        return self._salt_size
+
+    @property
+    def hash_size(self) -> int:
+        """Size of each password hash, in bytes."""
+        return self._hash_size
+
+    @property
+    def salts(self) -> memoryview:
+        """The salt column: the salt of user `i` is at `[i * salt_size : (i + 1) * salt_size]`."""
+        return self._salts
+
+    @property
+    def hashes(self) -> memoryview:
+        """The hash column: the hash of user `i` is at `[i * hash_size : (i + 1) * hash_size]`."""
+        return self._hashes
+
+    @property
+    def has_plaintexts(self) -> bool:
+        """Whether the database stores the plaintext passwords."""
+        return len(self._offsets) > 0
+
+    def __init__(
+        self,
+        hashes: bytes | bytearray | memoryview,
+        hash_size: int,
+        salts: bytes | bytearray | memoryview = b"",
+        salt_size: int = 0,
+        offsets: memoryview | array[int] | None = None,
+        heap: bytes | bytearray | memoryview = b"",
+    ) -> None:
+        """
+        Wrap existing columns.
+
+        :param hashes: The hash column.
+        :param hash_size: Size of each hash, in bytes.
+        :param salts: The salt column.
+        :param salt_size: Size of each salt, in bytes.
+        :param offsets: Offsets of each plaintext in the heap, plus the end of the heap.
+        :param heap: The plaintext heap.
+        """
+        self._hashes = memoryview(hashes)
+        self._hash_size = hash_size
+        self._salts = memoryview(salts)
+        self._salt_size = salt_size
+        offsets_view = memoryview(offsets if offsets is not None else array("Q"))
+        self._offsets = offsets_view if offsets_view.format == "Q" else offsets_view.cast("Q")
+        self._heap = memoryview(heap)
+        self._len = len(self._hashes) // hash_size if hash_size else 0
+        self._mmap: mmap.mmap | None = None
+        self._layout: list[slice] = []
+
+    @classmethod
+    def from_records(
+        cls,
+        records: Iterable[tuple[bytes, bytes | None, bytes | None]],
+    ) -> Self:
+        """
+        Build a database from (hash, salt, plaintext) records.
+
+        :param records: The records. Salts and plaintexts can be None.
+        :return: The database.
+        """
+        hashes, salts, heap = bytearray(), bytearray(), bytearray()
+        offsets = array("Q", [0])
+        hash_size = salt_size = -1
+        for digest, record_salt, plaintext in records:
+            salt = record_salt or b""
+            if hash_size < 0:
+                hash_size, salt_size = len(digest), len(salt)
+            if len(digest) != hash_size or len(salt) != salt_size:
+                err_msg = "All hashes and salts must have the same size"
+                raise ValueError(err_msg)
+            hashes.extend(digest)
+            salts.extend(salt)
+            if plaintext is not None:
+                heap.extend(plaintext)
+                offsets.append(len(heap))
+        if len(offsets) == 1:
+            offsets = array("Q")
+        elif len(offsets) != len(hashes) // hash_size + 1:
+            err_msg = "Either all or no records must have a plaintext"
+            raise ValueError(err_msg)
+        return cls(hashes, max(hash_size, 0), salts, max(salt_size, 0), offsets, heap)
+
+    @classmethod
+    def from_dict(cls, db: Mapping[int, dict[str, bytes]]) -> Self:
+        """
+        Convert a database returned by `generate_password_database`.
+
+        :param db: The dictionary database. User IDs must be 0, 1, 2, ...
+        :return: The columnar database.
+        """
+        if list(db) != list(range(len(db))):
+            err_msg = "User IDs must be consecutive and start from 0"
+            raise ValueError(err_msg)
+        return cls.from_records((r["password"], r.get("salt"), None) for r in db.values())
+
+    @classmethod
+    def generate(
+        cls,
+        length: int,
+        hash_function: Callable[[bytes, bytes | None], bytes],
+        salt_length: int = 16,
+        random_ratio: float = 0.5,
+        random_min_length: int = 8,
+        random_max_length: int = 16,
+        *,
+        keep_plaintexts: bool = True,
+    ) -> Self:
+        """
+        Generate a columnar password database.
+
+        :param length: Total number of passwords to generate.
+        :param hash_function: Hash function to use for password hashing.
+        :param salt_length: Length of the salt to use for hashing.
+        :param random_ratio: Ratio of random passwords to total passwords.
+        :param random_min_length: Minimum length of random passwords.
+        :param random_max_length: Maximum length of random passwords.
+        :param keep_plaintexts: Whether to store the plaintext passwords.
+        :return: The database.
+        """
+        passwords = generate_passwords(length, random_ratio, random_min_length, random_max_length)
+        log.info("Generating password database...")
+
+        def records() -> Iterator[tuple[bytes, bytes | None, bytes | None]]:
+            for password in log.percent(passwords, print_current=False):
+                data = password.encode()
+                salt = random_bytes(salt_length) if salt_length > 0 else None
+                yield hash_function(data, salt), salt, data if keep_plaintexts else None
+
+        return cls.from_records(records())
+
+    def save(self, path: str | Path) -> None:
+        """
+        Save the database to a file.
+
+        :param path: Path of the file.
+        """
+        header = _HEADER.pack(
+            _MAGIC,
+            _VERSION,
+            _FLAG_PLAINTEXTS if self.has_plaintexts else 0,
+            self._len,
+            self._salt_size,
+            self._hash_size,
+            len(self._heap),
+        )
+        with Path(path).open("wb") as f:
+            for section in (header, self._salts, self._hashes, self._offsets.cast("B"), self._heap):
+                f.write(section)
+                f.write(bytes(_aligned(len(section)) - len(section)))
+
+    @classmethod
+    def load(cls, path: str | Path) -> Self:
+        """
+        Memory-map a database saved by `save`.
+
+        :param path: Path of the file.
+        :return: The database, backed by the mapped file.
+        """
+        with Path(path).open("rb") as f:
+            mapped = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        view = memoryview(mapped)
+        magic, version, flags, count, salt_size, hash_size, heap_size = _HEADER.unpack_from(view)
+        if magic != _MAGIC or version != _VERSION:
+            err_msg = f"{path} is not a password database"
+            raise ValueError(err_msg)
+
+        offsets_size = (count + 1) * 8 if flags & _FLAG_PLAINTEXTS else 0
+        layout: list[slice] = []
+        pos = _aligned(_HEADER.size)
+        for size in (count * salt_size, count * hash_size, offsets_size, heap_size):
+            layout.append(slice(pos, pos + size))
+            pos += _aligned(size)
+        salts, hashes, offsets, heap = (view[section] for section in layout)
+
+        db = cls(hashes, hash_size, salts, salt_size, offsets, heap)
+        db._mmap = mapped
+        db._layout = layout
+        return db
+
+    def close(self) -> None:
+        """
+        Release the mapped file, if any.
+
+        .. note::
+            The mapped file cannot be released while views of its columns are alive, such as those
+            yielded by `iter_hashes`: callers must release or drop them first. Otherwise, this
+            method raises `BufferError` and leaves the database open and usable, so that it can be
+            closed again later. Closing a closed database does nothing.
+        """
+        for view in (self._salts, self._hashes, self._offsets, self._heap):
+            view.release()
+        if self._mmap is None:
+            return
+        try:
+            self._mmap.close()
+        except BufferError:
+            # Map the columns again, so that the database stays usable.
+            view = memoryview(self._mmap)
+            self._salts, self._hashes, offsets, self._heap = (view[s] for s in self._layout)
+            self._offsets = offsets.cast("Q")
+            err_msg = "Cannot close the database while views of its columns are alive"
+            raise BufferError(err_msg) from None
+        self._mmap = None
+
+    def __enter__(self) -> Self:
+        return self
+
+    def __exit__(
+        self,
+        exc_type: type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        self.close()
+
+    def hash(self, user: int) -> bytes:
+        """
+        Return the password hash of a user.
+
+        :param user: The user ID.
+        :return: The password hash.
+        """
+        return bytes(self._hashes[user * self._hash_size : (user + 1) * self._hash_size])
+
+    def salt(self, user: int) -> bytes | None:
+        """
+        Return the salt of a user.
+
+        :param user: The user ID.
+        :return: The salt, or None if passwords are unsalted.
+        """
+        if not self._salt_size:
+            return None
+        return bytes(self._salts[user * self._salt_size : (user + 1) * self._salt_size])
+
+    def plaintext(self, user: int) -> bytes | None:
+        """
+        Return the plaintext password of a user.
+
+        :param user: The user ID.
+        :return: The plaintext password, or None if plaintexts are not stored.
+        """
+        if not self.has_plaintexts:
+            return None
+        return bytes(self._heap[self._offsets[user] : self._offsets[user + 1]])
+
+    def iter_hashes(self) -> Iterator[memoryview]:
+        """
+        Iterate over the hash column without copying it.
+
+        :return: An iterator of hash views, in user ID order.
+        """
+        size = self._hash_size
+        hashes = self._hashes
+        return (hashes[i : i + size] for i in range(0, len(hashes), size))
+
+    def __len__(self) -> int:
+        return self._len
+
+    def __iter__(self) -> Iterator[int]:
+        return iter(range(self._len))
+
+    def __getitem__(self, user: int) -> dict[str, bytes]:
+        if not 0 <= user < self._len:
+            raise KeyError(user)
+        record = {"password": self.hash(user)}
+        if salt := self.salt(user):
+            record["salt"] = salt
+        return record
@@ -1,17 +1,25 @@
+import functools
+import hashlib
 import itertools
 import os
+import queue
 import secrets
 import string
+import sys
 import threading
 import time
-from collections.abc import Iterable, Iterator, Sequence
+from collections import deque
+from collections.abc import Callable, Iterable, Iterator, Sequence
+from concurrent.futures import ThreadPoolExecutor
 from typing import Any
 
+from cryptography.hazmat.primitives import hashes
+
 from . import _log as log
-from ._bytes import byte_size, xor
+from ._bytes import byte_size
 from ._crypto import AES256, CTR, BlockCipher, StreamCipher
 from ._hash import sha256
-from ._verify import HMAC, SHA1, Hash
+from ._verify import HMAC, SHA1, SHA256, Hash
 
 
 class RNG[SeedType: (int, bytes)]:
@@ -131,65 +139,300 @@ class CipherRNG(RNG[bytes]):
         self._key_stream = self._cipher.key_stream(iv)
 
 
+def _digest_function(hash_fn: Hash) -> Callable[[bytes], bytes]:
+    if type(hash_fn) is SHA256:
+        return lambda data: hashlib.sha256(data).digest()
+    if type(hash_fn) is SHA1:
+        return lambda data: hashlib.sha1(data).digest()  # noqa: S324
+    return hash_fn.compute_code
+
+
+def _default_workers() -> int:
+    # Hashing short inputs holds the GIL, so threads only pay off on free-threaded builds.
+    gil_enabled = getattr(sys, "_is_gil_enabled", lambda: True)()
+    return 1 if gil_enabled else os.cpu_count() or 1
+
+
 class HashRNG(RNG[bytes]):
-    """RNG based on a hash function."""
+    """
+    RNG based on a hash function.
 
-    def __init__(self, hash_fn: Hash) -> None:
+    .. note::
+        The output is the concatenation of the hashes of consecutive counter values, starting
+        from the seed. Blocks are independent of each other, so the generator supports random
+        access via `seek`, and large requests are split across worker threads.
+    """
+
+    BATCH_BLOCKS = 64
+    PARALLEL_THRESHOLD = 2**16
+
+    def __init__(self, hash_fn: Hash, workers: int | None = None) -> None:
+        """
+        Initialize the RNG.
+
+        :param hash_fn: The hash function to use.
+        :param workers: Number of threads used for large requests.
+                        If None, uses all CPUs on free-threaded builds and one otherwise.
+        """
         self._hash = hash_fn
-        self._stream = self._new_stream(int.from_bytes(os.urandom(hash_fn.code_size)))
+        self._digest = _digest_function(hash_fn)
+        self._workers = max(1, workers or _default_workers())
+        self._counter = 0
+        self._buffer = b""
+        self._pos = 0
+        self.seek(int.from_bytes(os.urandom(hash_fn.code_size)))
+
+    def _blocks(self, start: int, count: int) -> bytes:
+        size = self._hash.code_size
+        digest = self._digest
+        return b"".join([digest(c.to_bytes(size)) for c in range(start, start + count)])
+
+    def _parallel_blocks(self, start: int, count: int) -> bytes:
+        if self._workers == 1 or count * self._hash.code_size < self.PARALLEL_THRESHOLD:
+            return self._blocks(start, count)
+        step = -(-count // self._workers)
+        starts = range(start, start + count, step)
+        counts = (min(step, start + count - s) for s in starts)
+        with ThreadPoolExecutor(self._workers) as executor:
+            return b"".join(executor.map(self._blocks, starts, counts))
 
     def __next__(self) -> int:
-        return next(self._stream)
+        if self._pos >= len(self._buffer):
+            self._buffer = self._blocks(self._counter, self.BATCH_BLOCKS)
+            self._counter += self.BATCH_BLOCKS
+            self._pos = 0
+        value = self._buffer[self._pos]
+        self._pos += 1
+        return value
+
+    def fill(self, buf: bytearray | memoryview) -> None:
+        """
+        Fill a buffer with the next bytes of the stream.
 
-    def _new_stream(self, seed: int) -> Iterator[int]:
-        while True:
-            yield from self._hash.compute_code(int.to_bytes(seed, self._hash.code_size))
-            seed += 1
+        :param buf: The buffer to fill.
+        """
+        size = len(buf)
+        buffered = self._buffer[self._pos : self._pos + size]
+        buf[: len(buffered)] = buffered
+        self._pos += len(buffered)
+        if (missing := size - len(buffered)) == 0:
+            return
+
+        count = -(-missing // self._hash.code_size)
+        data = self._parallel_blocks(self._counter, count)
+        self._counter += count
+        buf[len(buffered) :] = data[:missing]
+        self._buffer = data
+        self._pos = missing
+
+    def seek(self, counter: int) -> None:
+        """
+        Move the stream to the start of the block produced by the given counter value.
+
+        :param counter: The counter value.
+        """
+        self._counter = counter
+        self._buffer = b""
+        self._pos = 0
 
     def set_seed(self, seed: bytes) -> None:
-        self._stream = self._new_stream(int.from_bytes(seed))
+        self.seek(int.from_bytes(seed))
+
+    def bytes(self, size: int) -> bytes:
+        buf = bytearray(max(0, size))
+        self.fill(buf)
+        return bytes(buf)
 
 
 class ANSIx917(RNG[bytes]):
-    """ANSI X9.17 RNG."""
+    """
+    ANSI X9.17 RNG.
+
+    .. note::
+        Each iteration of the algorithm produces a full cipher block. As in the original
+        algorithm, `__next__` runs one iteration per value and discards the rest of the block.
+        `fill` and `bytes` instead copy whole blocks into the output, so they produce different
+        bytes than concatenated values, and sample the timestamp once per request rather than
+        once per block: with a fixed clock, their output is the sequence of blocks produced
+        by the original algorithm.
+    """
 
     VALUE_SIZE = 8
 
-    def __init__(self, cipher: BlockCipher | None = None) -> None:
+    def __init__(
+        self,
+        cipher: BlockCipher | None = None,
+        clock: Callable[[], int] = time.time_ns,
+    ) -> None:
+        """
+        Initialize the RNG.
+
+        :param cipher: The block cipher to use. If None, AES-256 with a random key is used.
+        :param clock: Timestamp source, in nanoseconds.
+        """
         self._cipher = cipher or AES256()
+        self._clock = clock
         self._state = bytes(self._cipher.block_size)
 
+    def fill(self, buf: bytearray | memoryview) -> None:
+        """
+        Fill a buffer with random bytes.
+
+        :param buf: The buffer to fill.
+        """
+        encrypt = self._cipher.encrypt
+        block_size = self._cipher.block_size
+        temp = int.from_bytes(encrypt(self._clock().to_bytes(block_size)))
+        state = self._state
+        for i in range(0, len(buf), block_size):
+            output = encrypt((int.from_bytes(state) ^ temp).to_bytes(block_size))
+            state = encrypt((int.from_bytes(output) ^ temp).to_bytes(block_size))
+            chunk = output[: len(buf) - i]
+            buf[i : i + len(chunk)] = chunk
+        self._state = state
+
     def __next__(self) -> int:
-        temp = self._cipher.encrypt(time.time_ns().to_bytes(self._cipher.block_size))
-        output = self._cipher.encrypt(xor(self._state, temp))
-        self._state = self._cipher.encrypt(xor(output, temp))
-        return int.from_bytes(output[: self.value_size])
+        block = bytearray(self._cipher.block_size)
+        self.fill(block)
+        return int.from_bytes(block[: self.value_size])
 
     def set_seed(self, seed: bytes) -> None:
         self._cipher.key = seed
 
+    def bytes(self, size: int) -> bytes:
+        """
+        Generate random bytes.
 
-class TRNG(RNG[bytes]):
-    """True Random Number Generator."""
+        :param size: The number of bytes to generate.
+        :return: A bytes object containing random bytes.
+        """
+        buf = bytearray(max(0, size))
+        self.fill(buf)
+        return bytes(buf)
 
-    @staticmethod
-    def _urandom_stream() -> Iterator[int]:
+
+def _getrandom(size: int) -> bytes:
+    if not hasattr(os, "getrandom"):
+        return os.urandom(size)
+    data = bytearray()
+    while len(data) < size:
+        data.extend(os.getrandom(size - len(data)))
+    return bytes(data)
+
+
+class _EntropyCache:
+    """
+    Double-buffered cache of OS entropy.
+
+    .. note::
+        Reads are served from the current buffer while a background thread refills the spare one.
+        If the spare buffer is not ready when the current one runs out, it is filled synchronously.
+        Both buffers are discarded in forked children, so that processes never share output.
+    """
+
+    BUFFER_SIZE = 2**16
+
+    def __init__(self) -> None:
+        self._reset()
+
+    def _reset(self) -> None:
+        self._lock = threading.Lock()
+        self._refill = threading.Event()
+        self._refilling = False
+        self._spare = queue.Queue[bytes](maxsize=1)
+        self._thread: threading.Thread | None = None
+        self._current = b""
+        self._pos = 0
+
+    def _refill_loop(self) -> None:
         while True:
-            yield from os.urandom(1024)
+            self._refill.wait()
+            self._refill.clear()
+            self._spare.put(_getrandom(self.BUFFER_SIZE))
+
+    def _swap(self) -> None:
+        # Called with the lock held. Each spare buffer is handed off exactly once through the queue,
+        # and a refill is only requested once the previous one has been consumed.
+        if self._thread is None:
+            self._thread = threading.Thread(target=self._refill_loop, daemon=True)
+            self._thread.start()
+        try:
+            self._current = self._spare.get_nowait()
+            self._refilling = False
+        except queue.Empty:
+            self._current = _getrandom(self.BUFFER_SIZE)
+        self._pos = 0
+        if not self._refilling:
+            self._refilling = True
+            self._refill.set()
+
+    def take(self, size: int) -> bytes:
+        """
+        Consume random bytes from the cache.
+
+        :param size: The number of bytes to consume.
+        :return: A bytes object containing random bytes.
+        """
+        if size <= 0:
+            return b""
+        if size >= self.BUFFER_SIZE:
+            return _getrandom(size)
+        with self._lock:
+            if self._pos + size <= len(self._current):
+                data = self._current[self._pos : self._pos + size]
+                self._pos += size
+                return data
+            data = self._current[self._pos :]
+            self._swap()
+            self._pos = size - len(data)
+            return data + self._current[: self._pos]
+
+
+_ENTROPY = _EntropyCache()
+if hasattr(os, "register_at_fork"):
+    os.register_at_fork(after_in_child=_ENTROPY._reset)  # noqa: SLF001
+
+
+class TRNG(RNG[bytes]):
+    """True Random Number Generator, backed by a shared cache of OS entropy."""
+
+    CHUNK_SIZE = 1024
 
     def __init__(self) -> None:
         super().__init__()
-        self._stream = self._urandom_stream()
+        self._chunk = b""
+        self._pos = 0
 
     def __next__(self) -> int:
-        return next(self._stream)
+        if self._pos >= len(self._chunk):
+            self._chunk = _ENTROPY.take(self.CHUNK_SIZE)
+            self._pos = 0
+        value = self._chunk[self._pos]
+        self._pos += 1
+        return value
 
     def set_seed(self, seed: bytes) -> None:
         del seed  # Unused
 
+    def bytes(self, size: int) -> bytes:
+        return _ENTROPY.take(max(0, size))
+
+
+class Fortuna(RNG[bytes]):
+    """
+    Fortuna RNG.
+
+    .. note::
+        Output is produced by AES-256 in CTR mode, one request at a time. After each request
+        the generator rekeys itself with two extra keystream blocks, so that past outputs cannot
+        be recovered from the current state. Entropy pools are running SHA-256 contexts fed
+        from a queue of entropy events, which the accumulator thread appends to without locking.
+    """
 
-class Fortuna(CipherRNG):
-    """Fortuna RNG."""
+    KEY_SIZE = AES256.KEY_SIZE
+    BLOCK_SIZE = AES256.BLOCK_SIZE
+    REKEY_BLOCKS = KEY_SIZE // BLOCK_SIZE
+    MAX_REQUEST_SIZE = 2**20
 
     def __init__(
         self,
@@ -198,9 +441,13 @@ class Fortuna(CipherRNG):
         reseed_length: int = 120,
         accumulation_rate: float = 1.0,
     ) -> None:
-        super().__init__(CTR(AES256()))
+        self._cipher = CTR(AES256())
+        self._counter = 0
+        self._buffer = b""
         self._sources = tuple(sources)
-        self._pools = tuple(bytearray() for _ in range(pools))
+        self._pools = [hashes.Hash(hashes.SHA256()) for _ in range(pools)]
+        self._pool_sizes = [0] * pools
+        self._events: deque[tuple[int, bytes]] = deque()
         self._reseed_length = reseed_length
         self._reseed_count = 0
         threading.Thread(
@@ -210,18 +457,27 @@ class Fortuna(CipherRNG):
         ).start()
 
     def _accumulate_entropy(self, interval: float) -> None:
+        # deque.append is atomic, so the accumulator never contends with the generator.
         while True:
             for source in self._sources:
-                for pool in self._pools:
-                    pool.extend(source.bytes(4))
+                for i in range(len(self._pools)):
+                    self._events.append((i, source.bytes(4)))
             time.sleep(interval)
 
+    def _drain_events(self) -> None:
+        events = self._events
+        while events:
+            i, data = events.popleft()
+            self._pools[i].update(data)
+            self._pool_sizes[i] += len(data)
+
     def _key_entropy(self) -> bytes:
         entropy = bytearray()
         for i, pool in enumerate(self._pools):
             if self._reseed_count % (2**i) == 0:
-                entropy.extend(sha256(pool))
-                pool.clear()
+                entropy.extend(pool.finalize())
+                self._pools[i] = hashes.Hash(hashes.SHA256())
+                self._pool_sizes[i] = 0
         return entropy
 
     def _reseed(self) -> None:
@@ -229,15 +485,51 @@ class Fortuna(CipherRNG):
         self._reseed_count += 1
         self.set_seed(sha256(self._cipher.key + sha256(self._key_entropy())))
 
-    def __next__(self) -> int:
-        self._log_pool_sizes()
-        if len(self._pools[0]) >= self._reseed_length:
+    def _generate(self, size: int) -> bytes:
+        self._drain_events()
+        if debug := log.with_level(log.DEBUG):
+            sizes = ", ".join(f"P{i}: {s} B" for i, s in enumerate(self._pool_sizes))
+            debug("[Fortuna] %s", sizes)
+        if self._pool_sizes[0] >= self._reseed_length:
             self._reseed()
-        return super().__next__()
 
-    def _log_pool_sizes(self) -> None:
-        sizes = ", ".join(f"P{i}: {len(pool)} B" for i, pool in enumerate(self._pools))
-        log.debug("[Fortuna] %s", sizes)
+        blocks = -(-size // self.BLOCK_SIZE)
+        stream = self._cipher.key_stream_bytes(
+            self._counter.to_bytes(self.BLOCK_SIZE),
+            (blocks + self.REKEY_BLOCKS) * self.BLOCK_SIZE,
+        )
+        self._counter = (self._counter + blocks + self.REKEY_BLOCKS) % 2 ** (self.BLOCK_SIZE * 8)
+        self._cipher.key = stream[blocks * self.BLOCK_SIZE :]
+        return stream[:size]
+
+    def __next__(self) -> int:
+        if not self._buffer:
+            self._buffer = self._generate(self.BLOCK_SIZE)
+        value = self._buffer[0]
+        self._buffer = self._buffer[1:]
+        return value
+
+    def set_seed(self, seed: bytes) -> None:
+        self._cipher.key = seed
+        self._buffer = b""
+
+    def bytes(self, size: int) -> bytes:
+        """
+        Generate random bytes, rekeying the generator after every request.
+
+        :param size: The number of bytes to generate.
+        :return: A bytes object containing random bytes.
+        """
+        out = bytearray()
+        while (missing := size - len(out)) > 0:
+            out.extend(self._generate(min(missing, self.MAX_REQUEST_SIZE)))
+        return bytes(out)
+
+    def byte_stream(self, size: int | None = None) -> Iterator[int]:
+        if size is None:
+            while True:
+                yield from self._generate(self.MAX_REQUEST_SIZE)
+        yield from self.bytes(size)
 
 
 class OTP(RNG[int]):
@@ -285,20 +577,82 @@ class HOTP(OTP):
 
 
 class TOTP(RNG[int]):
-    """Time-based One-Time Password (TOTP) generator."""
+    """
+    Time-based One-Time Password (TOTP) generator.
+
+    .. note::
+        Codes only change every `period` seconds, so the code of the current time step is cached
+        and only recomputed on step rollover. Codes of the neighbouring steps, used by `verify`
+        to tolerate clock skew, are computed lazily and kept until they fall out of the window,
+        except for the next step's code, which is computed on rollover so that it is ready
+        by the time it becomes current. Times before the epoch count as step 0.
+    """
 
-    def __init__(self, key: bytes, digits: int = 6, period: int = 30, epoch: int = 0) -> None:
+    def __init__(
+        self,
+        key: bytes,
+        digits: int = 6,
+        period: int = 30,
+        epoch: int = 0,
+        window: int = 1,
+    ) -> None:
+        """
+        Initialize the generator.
+
+        :param key: The shared secret key.
+        :param digits: Number of digits of the codes.
+        :param period: Duration of a time step, in seconds.
+        :param epoch: Time from which steps are counted, in seconds since the Unix epoch.
+        :param window: Number of steps before and after the current one accepted by `verify`.
+        """
         self._hmac = HMAC(SHA1(), key)
         self._digits = max(1, min(10, digits))
         self._period = max(1, period)
         self._epoch = epoch
+        self._window = max(0, window)
+        self._codes: dict[int, int] = {}
+        self._step: int | None = None
+        self._code = 0
+
+    def _code_at(self, step: int) -> int:
+        if (code := self._codes.get(step)) is None:
+            code = self._codes[step] = HOTP.code(self._hmac, step, self._digits)
+        return code
+
+    def _current(self) -> int:
+        step = max(0, int((time.time() - self._epoch) / self._period))
+        if step != self._step:
+            oldest = step - self._window
+            self._codes = {s: c for s, c in self._codes.items() if s >= oldest}
+            self._code = self._code_at(step)
+            self._code_at(step + 1)
+            self._step = step
+        return step
 
     def __next__(self) -> int:
-        t = int((time.time() - self._epoch) / self._period)
-        return HOTP.code(self._hmac, t, self._digits)
+        self._current()
+        return self._code
+
+    def verify(self, code: int) -> bool:
+        """
+        Check a code against the current time step and its neighbours.
+
+        :param code: The code to check.
+        :return: True if the code is valid, False otherwise.
+        """
+        step = self._current()
+        if code == self._code:
+            return True
+        return any(
+            self._code_at(step + delta) == code
+            for delta in range(-self._window, self._window + 1)
+            if delta and step + delta >= 0
+        )
 
     def set_seed(self, seed: int) -> None:
         self._epoch = seed
+        self._codes.clear()
+        self._step = None
 
 
 def random_bytes(size: int) -> bytes:
@@ -308,7 +662,18 @@ def random_bytes(size: int) -> bytes:
     :param size: The number of random bytes to generate.
     :return: A bytes object containing random bytes.
     """
-    return secrets.token_bytes(size)
+    return _ENTROPY.take(size)
+
+
+@functools.cache
+def _charset_tables(charset: str) -> tuple[int, bytes, str, bytes | None]:
+    # Random bytes at or above `limit` would bias the result, so they are deleted. The remaining
+    # values map to characters by plain lookup, via `bytes.translate` for ASCII charsets.
+    limit = 256 - 256 % len(charset)
+    rejected = bytes(range(limit, 256))
+    table = charset * (limit // len(charset))
+    ascii_table = table.encode().ljust(256, b"\x00") if table.isascii() else None
+    return limit, rejected, table, ascii_table
 
 
 def random_string(length: int, charset: str = string.printable) -> str:
@@ -319,7 +684,21 @@ def random_string(length: int, charset: str = string.printable) -> str:
     :param charset: The character set to use for generating the string.
     :return: A random string.
     """
-    return "".join(secrets.choice(charset) for _ in range(length))
+    if not charset:
+        err_msg = "Character set must not be empty"
+        raise ValueError(err_msg)
+    if len(charset) > 256:  # noqa: PLR2004
+        return "".join(secrets.choice(charset) for _ in range(length))
+
+    limit, rejected, table, ascii_table = _charset_tables(charset)
+    indices = bytearray()
+    while (missing := length - len(indices)) > 0:
+        batch = _ENTROPY.take(missing * 256 // limit + 8).translate(None, rejected)
+        indices.extend(batch[:missing])
+
+    if ascii_table is not None:
+        return indices.translate(ascii_table).decode()
+    return "".join(map(table.__getitem__, indices))
 
 
 def random_int(min_value: int = 0, max_value: int = 2**32 - 1) -> int:
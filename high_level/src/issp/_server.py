@@ -1,7 +1,10 @@
+from collections.abc import Mapping
 from typing import TYPE_CHECKING, Any
 
 from . import _log as log
 from ._comm import Channel, Message, Plaintext
+from ._files import FileStore
+from ._ledger import Ledger
 
 if TYPE_CHECKING:
     from collections.abc import Callable
@@ -55,6 +58,16 @@ class Server:
             response = self._handle(sender, body)
             channel.send(Message(self.name, sender, response))
 
+    def process(self, msg: Message) -> Message:
+        """
+        Handle a message as if it had been received from the medium, without sending the response.
+
+        :param msg: The message, as received from the medium.
+        :return: The response, as it would be sent to the medium.
+        """
+        sender, channel, body = self._decode(msg)
+        return channel.stack.encode(Message(self.name, sender, self._handle(sender, body)))
+
     def _register(self, sender: str, body: dict[str, Any]) -> dict[str, Any]:
         return {"status": "success" if self.register(sender, body) else "failure"}
 
@@ -85,43 +98,70 @@ class Server:
 
 
 class BankServer(Server):
+    SNAPSHOT_INTERVAL = 1000
+    """Number of transactions between two logged snapshots of all balances."""
+
     def authorize(self, sender: str, body: dict[str, Any]) -> bool:
         del sender, body  # Unused
         return True
 
-    def __init__(self, name: str, channels: Channel | dict[str, Channel]) -> None:
+    def __init__(
+        self,
+        name: str,
+        channels: Channel | dict[str, Channel],
+        ledger: Ledger | None = None,
+    ) -> None:
         super().__init__(name, channels)
-        self.db: dict[str, dict[str, Any]] = {}
+        self.db = Ledger() if ledger is None else ledger
+        self._next_snapshot = self.SNAPSHOT_INTERVAL
         self.add_handler("perform_transaction", self._perform_transaction)
+        self.add_handler("perform_transactions", self._perform_transactions)
 
     def _perform_transaction(self, sender: str, body: dict[str, Any]) -> dict[str, Any]:
         recipient = body["recipient"]
-        user_record = self.db[sender]
-        recipient_record = self.db[recipient]
         amount = body["amount"]
-
-        if amount <= 0:
-            return {"status": "invalid amount"}
-
-        if user_record["balance"] < amount:
-            return {"status": "insufficient funds"}
-
-        user_record["balance"] -= amount
-        recipient_record["balance"] += amount
-
-        log.info(
-            "[%s] Current balances: %s",
-            self.name,
-            {k: v["balance"] for k, v in self.db.items()},
-        )
-
-        return {"status": "success", "recipient": recipient, "amount": amount}
+        if (status := self.db.transfer(sender, recipient, amount)) != "success":
+            return {"status": status}
+        self._log_balances(sender, recipient)
+        return {"status": status, "recipient": recipient, "amount": amount}
+
+    def _perform_transactions(self, sender: str, body: dict[str, Any]) -> dict[str, Any]:
+        transfers = [(sender, t["recipient"], t["amount"]) for t in body["transactions"]]
+        if (status := self.db.transfer_batch(transfers)) != "success":
+            return {"status": status}
+        self._log_balances(sender, *(recipient for _, recipient, _ in transfers))
+        return {"status": status, "count": len(transfers)}
+
+    def _log_balances(self, *owners: str) -> None:
+        # Only the accounts involved in a transaction are logged, plus periodic snapshots.
+        log.info("[%s] Current balances: %s", self.name, self.db.balances(*owners))
+        if self.db.transactions >= self._next_snapshot:
+            self._next_snapshot = self.db.transactions + self.SNAPSHOT_INTERVAL
+            log.info("[%s] Snapshot: %s", self.name, self.db.snapshot())
 
 
 class FileServer(Server):
-    def __init__(self, name: str, channels: Channel | dict[str, Channel]) -> None:
+    @property
+    def files(self) -> FileStore:
+        """Files of the server. Assigning a dictionary replaces them, keeping the storage."""
+        return self._files
+
+    @files.setter
+    def files(self, files: Mapping[str, str]) -> None:
+        if isinstance(files, FileStore):
+            self._files = files
+        else:
+            self._files.clear()
+            self._files.update(files)
+
+    def __init__(
+        self,
+        name: str,
+        channels: Channel | dict[str, Channel],
+        store: FileStore | None = None,
+    ) -> None:
         super().__init__(name, channels)
-        self.files: dict[str, str] = {}
+        self._files = FileStore() if store is None else store
         self.add_handler("read", self._read)
         self.add_handler("write", self._write)
 
@@ -135,11 +175,12 @@ class FileServer(Server):
 
     def _read(self, sender: str, body: dict[str, Any]) -> dict[str, Any]:
         del sender  # Unused
-        if data := self.files.get(body["path"]):
-            return {"status": "success", "data": data}
-        return {"status": "not found"}
+        if (path := body["path"]) not in self.files:
+            return {"status": "not found"}
+        data = self.files.read(path, body.get("offset", 0), body.get("length"))
+        return {"status": "success", "data": data}
 
     def _write(self, sender: str, body: dict[str, Any]) -> dict[str, Any]:
         del sender  # Unused
-        self.files[body["path"]] += body["data"]
+        self.files.append(body["path"], body["data"])
         return {"status": "success"}
@@ -0,0 +1,461 @@
+from __future__ import annotations
+
+import _multiprocessing
+import math
+import multiprocessing
+import platform
+import queue
+import secrets
+import struct
+import sys
+import threading
+from multiprocessing import shared_memory
+from typing import TYPE_CHECKING, Any
+
+from . import _log as log
+from ._comm import Actor, Channel, Clock, Medium, Message
+
+if TYPE_CHECKING:
+    from collections.abc import Callable
+    from multiprocessing.context import BaseContext
+    from multiprocessing.synchronize import Semaphore
+
+# Layout of the shared memory segment, all integers being little-endian:
+#
+# - Header: magic, layout version, number of slots and slot size, as `_HEADER`, followed by
+#   the ring head and ring tail, as unsigned 64-bit counters.
+# - Ring: `slots + 1` unsigned 32-bit slot indexes, written by parties when they post a request
+#   and read by the medium. The extra entry is for the stop request posted by the parent process.
+# - Slots: one per party, each made of a `_SLOT` header followed by `slot_size` bytes of data,
+#   padded to 8 bytes. Requests are written by the party and replaced by responses written
+#   by the medium.
+#
+# Messages in slots are encoded as `_MESSAGE` (sender size, recipient size, body size) followed
+# by the UTF-8 sender, the UTF-8 recipient and the body.
+#
+# On POSIX systems, the segment is signalled through named semaphores, so that processes not
+# started by Python, such as the C client in `low_level/tools`, can attach to it by name:
+#
+# - "/<segment>-lock": binary semaphore guarding the ring head and tail.
+# - "/<segment>-ring": number of requests in the ring.
+# - "/<segment>-<index>": posted by the medium when the response in a slot is ready.
+
+_MAGIC = b"ISSPSHM\x00"
+_VERSION = 1
+_HEADER = struct.Struct("<8sIII4x")  # magic, version, slots, slot size
+_COUNTERS = struct.Struct("<QQ")  # ring head, ring tail
+_RING_ENTRY = struct.Struct("<I")
+_SLOT = struct.Struct("<BBxxqdI4x")  # op/status, flags, value, timeout, data size
+_MESSAGE = struct.Struct("<HHI")
+
+_OP_READ = 1
+_OP_WRITE = 2
+_OP_WAIT = 3
+_OP_PEEK = 4
+_OP_CLOSE = 5
+
+_STATUS_OK = 0
+_STATUS_TIMEOUT = 1
+_STATUS_ERROR = 2
+
+_FLAG_CLEAR = 1
+_FLAG_TOKEN = 2
+
+
+def _encode_message(msg: Message) -> bytes:
+    sender, recipient = msg.sender.encode(), msg.recipient.encode()
+    return _MESSAGE.pack(len(sender), len(recipient), len(msg.body)) + sender + recipient + msg.body
+
+
+def _decode_message(data: bytes) -> Message:
+    sender_size, recipient_size, body_size = _MESSAGE.unpack_from(data)
+    start = _MESSAGE.size
+    sender = data[start : start + sender_size].decode()
+    start += sender_size
+    recipient = data[start : start + recipient_size].decode()
+    start += recipient_size
+    return Message(sender, recipient, data[start : start + body_size])
+
+
+def _semlock(name: str, value: int | None = None, *, unlink: bool = False) -> Any:  # noqa: ANN401
+    # The only access to the private semaphore API of CPython's `_multiprocessing`, which wraps
+    # `sem_open` and `sem_unlink`: `SemLock(kind, value, max_value, name, unlink)` creates
+    # a semaphore, `SemLock._rebuild(handle, kind, max_value, name)` opens an existing one,
+    # and `sem_unlink(name)` removes it. Its signatures have been stable since Python 3.8,
+    # but are not guaranteed, so any mismatch is reported as such.
+    err_msg = (
+        f"Named semaphores are not supported by {sys.implementation.name} "
+        f"{platform.python_version()}: the semaphore API of _multiprocessing does not match"
+    )
+    if sys.implementation.name != "cpython":
+        raise RuntimeError(err_msg)
+    try:
+        kind, max_value = 1, _multiprocessing.SemLock.SEM_VALUE_MAX  # Counting semaphore.
+        if unlink:
+            return _multiprocessing.sem_unlink(name)
+        if value is None:
+            return _multiprocessing.SemLock._rebuild(0, kind, max_value, name)  # noqa: SLF001
+        return _multiprocessing.SemLock(kind, value, max_value, name, False)  # noqa: FBT003
+    except (AttributeError, TypeError) as e:
+        raise RuntimeError(err_msg) from e
+
+
+class _NamedSemaphore:
+    # POSIX named semaphore, which other processes open by name. Pickled by name, so that
+    # spawned processes open the same semaphore.
+
+    def __init__(self, name: str, value: int | None = None) -> None:
+        self.name = name
+        self._sem = _semlock(name, value)
+
+    def __getstate__(self) -> str:
+        return self.name
+
+    def __setstate__(self, name: str) -> None:
+        self.__init__(name)
+
+    def __enter__(self) -> bool:
+        return self._sem.acquire()
+
+    def __exit__(self, *args: object) -> None:
+        self._sem.release()
+
+    def acquire(self) -> bool:
+        return self._sem.acquire()
+
+    def release(self) -> None:
+        self._sem.release()
+
+    def unlink(self) -> None:
+        _semlock(self.name, unlink=True)
+
+
+class _Segment:
+    # Shared memory and semaphores, created by the parent process and inherited by the parties.
+
+    def __init__(self, slots: int, slot_size: int, name: str | None, ctx: BaseContext) -> None:
+        self.slots = slots
+        self.slot_size = slot_size
+        self._ring_offset = _HEADER.size + _COUNTERS.size
+        ring_size = _RING_ENTRY.size * (slots + 1)
+        self._slots_offset = self._ring_offset + (ring_size + 7) // 8 * 8
+        self._slot_stride = _SLOT.size + (slot_size + 7) // 8 * 8
+        size = self._slots_offset + self._slot_stride * slots
+        # Short names, since semaphore names are limited to 31 characters on some systems.
+        name = name or f"issp-{secrets.token_hex(4)}"
+        self._shm = shared_memory.SharedMemory(name, create=True, size=size)
+        _HEADER.pack_into(self._shm.buf, 0, _MAGIC, _VERSION, slots, slot_size)
+        _COUNTERS.pack_into(self._shm.buf, _HEADER.size, 0, 0)
+        self._semaphores: list[_NamedSemaphore] = []
+        try:
+            self._ring_lock = self._semaphore("lock", 1, ctx)
+            self._ring_items = self._semaphore("ring", 0, ctx)
+            self._done = [self._semaphore(str(i), 0, ctx) for i in range(slots)]
+        except BaseException:
+            self.close()
+            self.unlink()
+            raise
+
+    @property
+    def name(self) -> str:
+        return self._shm.name
+
+    def _semaphore(self, suffix: str, value: int, ctx: BaseContext) -> _NamedSemaphore | Semaphore:
+        # Windows has no named POSIX semaphores, so the segment can only be used from Python there.
+        if sys.platform == "win32":
+            return ctx.Semaphore(value)
+        sem = _NamedSemaphore(f"/{self.name}-{suffix}", value)
+        self._semaphores.append(sem)
+        return sem
+
+    def post(self, index: int) -> None:
+        buf = self._shm.buf
+        with self._ring_lock:
+            head, tail = _COUNTERS.unpack_from(buf, _HEADER.size)
+            offset = self._ring_offset + _RING_ENTRY.size * (tail % (self.slots + 1))
+            _RING_ENTRY.pack_into(buf, offset, index)
+            _COUNTERS.pack_into(buf, _HEADER.size, head, tail + 1)
+        self._ring_items.release()
+
+    def next(self) -> int:
+        # Only called by the medium, which is the only consumer of the ring.
+        self._ring_items.acquire()
+        buf = self._shm.buf
+        with self._ring_lock:
+            head, tail = _COUNTERS.unpack_from(buf, _HEADER.size)
+            offset = self._ring_offset + _RING_ENTRY.size * (head % (self.slots + 1))
+            (index,) = _RING_ENTRY.unpack_from(buf, offset)
+            _COUNTERS.pack_into(buf, _HEADER.size, head + 1, tail)
+        return index
+
+    def write_slot(
+        self,
+        index: int,
+        code: int,
+        data: bytes = b"",
+        *,
+        flags: int = 0,
+        value: int = 0,
+        timeout: float | None = None,
+    ) -> None:
+        if len(data) > self.slot_size:
+            err_msg = f"Data of size {len(data)} exceeds the slot size ({self.slot_size})"
+            raise ValueError(err_msg)
+        offset = self._slots_offset + self._slot_stride * index
+        timeout = math.nan if timeout is None else timeout
+        _SLOT.pack_into(self._shm.buf, offset, code, flags, value, timeout, len(data))
+        offset += _SLOT.size
+        self._shm.buf[offset : offset + len(data)] = data
+
+    def read_slot(self, index: int) -> tuple[int, int, int, float | None, bytes]:
+        offset = self._slots_offset + self._slot_stride * index
+        code, flags, value, timeout, size = _SLOT.unpack_from(self._shm.buf, offset)
+        offset += _SLOT.size
+        data = bytes(self._shm.buf[offset : offset + size])
+        return code, flags, value, None if math.isnan(timeout) else timeout, data
+
+    def wait_done(self, index: int) -> None:
+        self._done[index].acquire()
+
+    def set_done(self, index: int) -> None:
+        self._done[index].release()
+
+    def close(self) -> None:
+        self._shm.close()
+
+    def unlink(self) -> None:
+        self._shm.unlink()
+        for sem in self._semaphores:
+            sem.unlink()
+
+
+class _PartyMedium(Medium):
+    # Medium of a party process, which forwards each operation to the medium of the parent process
+    # and blocks until it completes.
+
+    def __init__(self, segment: _Segment, index: int, interval: float) -> None:
+        self._segment = segment
+        self._index = index
+        self._interval = interval
+        self._clock = Clock()
+
+    def _call(
+        self,
+        op: int,
+        data: bytes = b"",
+        *,
+        flags: int = 0,
+        value: int = 0,
+        timeout: float | None = None,
+    ) -> bytes:
+        self._segment.write_slot(self._index, op, data, flags=flags, value=value, timeout=timeout)
+        self._segment.post(self._index)
+        self._segment.wait_done(self._index)
+        status, _, _, _, data = self._segment.read_slot(self._index)
+        if status == _STATUS_TIMEOUT:
+            raise TimeoutError(data.decode())
+        if status == _STATUS_ERROR:
+            raise RuntimeError(data.decode())
+        return data
+
+    def peek(self) -> Message:
+        return _decode_message(self._call(_OP_PEEK))
+
+    def subscribe(
+        self,
+        predicate: Callable[[Message], bool],
+        *,
+        timeout: float | None = None,
+    ) -> Message:
+        # Predicates cannot be sent to the parent process, so the medium is polled instead.
+        deadline = None if timeout is None else self._clock.time() + timeout
+        while not predicate(msg := self.peek()):
+            if deadline is not None and self._clock.time() >= deadline:
+                err_msg = f"Timed out after {timeout:g} seconds"
+                raise TimeoutError(err_msg)
+            self._clock.sleep(self._interval * 0.5)
+        return msg
+
+    def read(
+        self,
+        recipient: str | None,
+        priority: int,
+        *,
+        timeout: float | None = None,
+        clear: bool = True,
+    ) -> Message:
+        flags = _FLAG_CLEAR if clear else 0
+        if recipient is not None:
+            flags |= _FLAG_TOKEN
+        token = (recipient or "").encode()
+        data = self._call(_OP_READ, token, flags=flags, value=priority, timeout=timeout)
+        return _decode_message(data)
+
+    def write(self, msg: Message, priority: int, *, timeout: float | None = None) -> None:
+        self._call(_OP_WRITE, _encode_message(msg), value=priority, timeout=timeout)
+
+    def wait(self, turns: int = 1) -> None:
+        self._call(_OP_WAIT, value=turns)
+
+    def close(self) -> None:
+        self._call(_OP_CLOSE)
+        self._segment.close()
+
+
+class _Hub:
+    # Runs in the parent process: a regular medium, plus one thread per party that performs
+    # the operations requested by that party, exactly as the party's own thread would.
+
+    def __init__(self, segment: _Segment, interval: float) -> None:
+        self._segment = segment
+        self._medium = Medium(interval=interval)
+        self._requests = [queue.SimpleQueue[None]() for _ in range(segment.slots)]
+        self._servers = [
+            threading.Thread(target=self._serve, args=(i,), daemon=True)
+            for i in range(segment.slots)
+        ]
+        self._dispatcher = threading.Thread(target=self._dispatch, daemon=True)
+
+    def start(self) -> None:
+        for t in self._servers:
+            t.start()
+        self._dispatcher.start()
+
+    def join(self, index: int) -> None:
+        # Waits until the party in a slot closes its medium.
+        self._servers[index].join()
+
+    def stop(self) -> None:
+        self._segment.post(self._segment.slots)
+        self._dispatcher.join()
+
+    def _dispatch(self) -> None:
+        while (index := self._segment.next()) < self._segment.slots:
+            self._requests[index].put(None)
+
+    def _serve(self, index: int) -> None:
+        while True:
+            self._requests[index].get()
+            op, flags, value, timeout, data = self._segment.read_slot(index)
+            try:
+                response = self._perform(op, flags, value, timeout, data)
+            except TimeoutError as e:
+                self._segment.write_slot(index, _STATUS_TIMEOUT, str(e).encode())
+            except Exception as e:
+                self._segment.write_slot(index, _STATUS_ERROR, str(e).encode())
+            else:
+                self._segment.write_slot(index, _STATUS_OK, response)
+            self._segment.set_done(index)
+            if op == _OP_CLOSE:
+                return
+
+    def _perform(
+        self,
+        op: int,
+        flags: int,
+        value: int,
+        timeout: float | None,
+        data: bytes,
+    ) -> bytes:
+        if op == _OP_READ:
+            token = data.decode() if flags & _FLAG_TOKEN else None
+            clear = bool(flags & _FLAG_CLEAR)
+            return _encode_message(self._medium.read(token, value, timeout=timeout, clear=clear))
+        if op == _OP_WRITE:
+            self._medium.write(_decode_message(data), value, timeout=timeout)
+        elif op == _OP_WAIT:
+            self._medium.wait(value)
+        elif op == _OP_PEEK:
+            return _encode_message(self._medium.peek())
+        elif op != _OP_CLOSE:
+            err_msg = f"Invalid operation: {op}"
+            raise ValueError(err_msg)
+        return b""
+
+
+def _run_party(segment: _Segment, index: int, actor: Actor, interval: float) -> None:
+    medium = _PartyMedium(segment, index, interval)
+    try:
+        channels = tuple(Channel(actor.name, medium, s, actor.priority) for s in actor.stacks)
+        actor.target(*channels, *actor.data)
+    finally:
+        medium.close()
+
+
+class ProcessActor(Actor):
+    """
+    An actor run in its own process.
+
+    .. note::
+        Actors communicate through a medium hosted by the parent process, which they reach through
+        a shared memory segment: a ring buffer of requests plus one slot per actor, signalled by
+        semaphores. The medium arbitrates reads and writes exactly as in `Actor.start`, so channels
+        behave the same, but each actor has its own interpreter and CPU-bound layers no longer
+        contend for the GIL.
+
+        Depending on the platform, processes may be spawned rather than forked, in which case
+        targets, stacks and data must be picklable, and the main module must be import-safe.
+
+        On POSIX systems, the segment is signalled through named semaphores, so that `external`
+        slots can be reserved for processes written in other languages, such as the C client
+        in `low_level/tools`, which attach to the segment by name. The layout of the segment
+        is documented in this module and mirrored by `low_level/tools/util/issp_shm.h`.
+        Named semaphores are opened through the private semaphore API of CPython's
+        `_multiprocessing` module, the one behind `multiprocessing.Semaphore`: on interpreters
+        where it differs, starting the actors raises `RuntimeError`.
+    """
+
+    @staticmethod
+    def start(
+        *args: Actor,
+        interval: float = 1.0,
+        virtual: bool | None = None,
+        slot_size: int = 1 << 16,
+        name: str | None = None,
+        external: int = 0,
+    ) -> None:
+        """
+        Run actors in separate processes on a shared medium until all of them return.
+
+        :param args: The actors.
+        :param interval: Duration of a tick of the medium, in seconds.
+        :param virtual: Must be None or False, since virtual time is not supported.
+        :param slot_size: Maximum size of an encoded message, in bytes.
+        :param name: Name of the shared memory segment. If None, a random name is used.
+        :param external: Number of slots reserved for external processes, which follow those
+                         of the actors. This method also waits for each of them to close its
+                         medium before returning.
+        """
+        if virtual:
+            err_msg = "Virtual time is not supported by process actors"
+            raise ValueError(err_msg)
+        if external and sys.platform == "win32":
+            err_msg = "External processes are not supported on Windows"
+            raise ValueError(err_msg)
+        ctx = multiprocessing.get_context()
+        segment = _Segment(len(args) + external, slot_size, name, ctx)
+        try:
+            # Processes are started before any thread, so that they can be safely forked.
+            processes = [
+                ctx.Process(target=_run_party, args=(segment, i, a, interval), name=a.name)
+                for i, a in enumerate(args)
+            ]
+            for p in processes:
+                p.start()
+            hub = _Hub(segment, interval)
+            hub.start()
+            if external:
+                log.info(
+                    "[Medium] External processes can attach to segment %s, slots %d to %d",
+                    segment.name,
+                    len(args),
+                    segment.slots - 1,
+                )
+            for p in processes:
+                p.join()
+            for i in range(len(args), segment.slots):
+                hub.join(i)
+            hub.stop()
+        finally:
+            segment.close()
+            segment.unlink()
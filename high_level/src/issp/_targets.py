@@ -0,0 +1,99 @@
+from __future__ import annotations
+
+import itertools
+from typing import TYPE_CHECKING
+
+from . import _log as log
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Iterable, Iterator, Mapping
+
+
+class TargetSet:
+    """
+    A set of target digests, optimized for checking many candidates against many targets.
+
+    .. note::
+        Digests are indexed by a dictionary built once, so that each lookup is a single
+        native hash probe regardless of the number of targets. Since digests are already
+        uniformly distributed, their hashes rarely collide.
+    """
+
+    def __init__(self, digests: Iterable[bytes]) -> None:
+        """
+        Build the set.
+
+        :param digests: The target digests, which must all have the same size.
+        """
+        self._indices: dict[bytes, int] = {}
+        for digest in map(bytes, digests):
+            self._indices.setdefault(digest, len(self._indices))
+        if len({len(d) for d in self._indices}) > 1:
+            err_msg = "Digests must all have the same size"
+            raise ValueError(err_msg)
+
+    def __len__(self) -> int:
+        return len(self._indices)
+
+    def __contains__(self, digest: object) -> bool:
+        return isinstance(digest, bytes | bytearray) and bytes(digest) in self._indices
+
+    def find(self, digest: bytes) -> int:
+        """
+        Look up a digest.
+
+        :param digest: The digest to look up.
+        :return: Index of the digest in the sequence the set was built from, after removing
+                 duplicates, or -1 if the digest is not a target.
+        """
+        return self._indices.get(digest, -1)
+
+    def find_all(self, digests: Iterable[bytes]) -> Iterator[int]:
+        """
+        Look up several digests, without a Python-level call per digest.
+
+        :param digests: The digests to look up.
+        :return: Iterator over the results of `find` for each digest.
+        """
+        return map(self._indices.get, digests, itertools.repeat(-1))
+
+
+def crack_unsalted(
+    db: Mapping[int, dict[str, bytes]],
+    candidates: Iterable[bytes],
+    hash_fn: Callable[[bytes], bytes],
+    batch_size: int = 2**12,
+) -> dict[int, str]:
+    """
+    Crack an unsalted password database, hashing each candidate once for all users.
+
+    :param db: The password database, e.g. from `generate_password_database`.
+    :param candidates: The candidate passwords, e.g. from `generate_bytes` or `mangle`.
+    :param hash_fn: The hash function used to build the database.
+    :param batch_size: Number of candidates hashed per batch.
+    :return: A dictionary mapping user IDs to their plaintext passwords.
+    """
+    users: dict[bytes, list[int]] = {}
+    for user, data in db.items():
+        if data.get("salt"):
+            err_msg = f"User {user} has a salted password"
+            raise ValueError(err_msg)
+        users.setdefault(data["password"], []).append(user)
+
+    targets = TargetSet(users)
+    owners = list(users.values())
+    remaining = len(targets)
+    cracked: dict[int, str] = {}
+
+    for batch in itertools.batched(candidates, batch_size):
+        for candidate, i in zip(batch, targets.find_all(map(hash_fn, batch)), strict=True):
+            if i < 0 or not owners[i]:
+                continue
+            password = candidate.decode(errors="replace")
+            log.debug("Cracked %d users: %s", len(owners[i]), password)
+            cracked.update(dict.fromkeys(owners[i], password))
+            owners[i] = []
+            if (remaining := remaining - 1) == 0:
+                return cracked
+
+    return cracked
@@ -0,0 +1,180 @@
+from __future__ import annotations
+
+import mmap
+import struct
+import threading
+from pathlib import Path
+from typing import TYPE_CHECKING, NamedTuple, Self
+
+from ._comm import Message
+
+if TYPE_CHECKING:
+    from collections.abc import Callable, Iterator
+    from types import TracebackType
+
+# A trace is a header followed by records. Each record starts with a `_RECORD` header, whose first
+# field is the size of the whole record, followed by the UTF-8 sender, the UTF-8 recipient
+# and the raw body of the message.
+
+_MAGIC = b"ISSPTRC\0"
+_VERSION = 1
+_HEADER = struct.Struct("<8sHxxxxxx")
+_RECORD = struct.Struct("<IQiHH")  # record size, tick, priority, sender size, recipient size
+
+
+class TraceRecord(NamedTuple):
+    """A message written to the medium, as stored in a trace."""
+
+    tick: int
+    """Tick of the medium in which the message was written."""
+    priority: int
+    """Priority of the write."""
+    sender: str
+    """Sender of the message."""
+    recipient: str
+    """Recipient of the message."""
+    body: bytes
+    """Raw body of the message, as encoded by the security stack of the sender."""
+
+    @property
+    def message(self) -> Message:
+        """The recorded message."""
+        return Message(self.sender, self.recipient, self.body)
+
+
+class TraceRecorder:
+    """
+    Records the messages written to a medium to a binary trace file.
+
+    Pass the recorder to `Actor.start` to record a run, then use `Trace` to replay it.
+    """
+
+    def __init__(self, path: str | Path) -> None:
+        """
+        Create a trace file, replacing any existing file.
+
+        :param path: Path of the file.
+        """
+        self._file = Path(path).open("wb")  # noqa: SIM115
+        self._file.write(_HEADER.pack(_MAGIC, _VERSION))
+        self._lock = threading.Lock()
+        self._count = 0
+
+    def __len__(self) -> int:
+        return self._count
+
+    def record(self, tick: int, priority: int, msg: Message) -> None:
+        """
+        Append a message to the trace.
+
+        :param tick: Tick of the medium in which the message was written.
+        :param priority: Priority of the write.
+        :param msg: The message.
+        """
+        sender, recipient = msg.sender.encode(), msg.recipient.encode()
+        size = _RECORD.size + len(sender) + len(recipient) + len(msg.body)
+        header = _RECORD.pack(size, tick, priority, len(sender), len(recipient))
+        with self._lock:
+            self._file.write(header + sender + recipient + msg.body)
+            self._count += 1
+
+    def close(self) -> None:
+        """Flush and close the trace file."""
+        with self._lock:
+            self._file.close()
+
+    def __enter__(self) -> Self:
+        return self
+
+    def __exit__(
+        self,
+        exc_type: type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        self.close()
+
+
+class Trace:
+    """A memory-mapped trace recorded by `TraceRecorder`."""
+
+    def __init__(self, path: str | Path) -> None:
+        """
+        Memory-map a trace file.
+
+        :param path: Path of the file.
+        """
+        with Path(path).open("rb") as f:
+            self._mmap = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        if len(self._mmap) < _HEADER.size or _HEADER.unpack_from(self._mmap) != (_MAGIC, _VERSION):
+            self._mmap.close()
+            err_msg = f"{path} is not a trace"
+            raise ValueError(err_msg)
+
+        # Index the records by only reading their sizes, ignoring a truncated last record.
+        self._offsets: list[int] = []
+        pos, end = _HEADER.size, len(self._mmap)
+        while pos + _RECORD.size <= end:
+            size = int.from_bytes(self._mmap[pos : pos + 4], "little")
+            if size < _RECORD.size or pos + size > end:
+                break
+            self._offsets.append(pos)
+            pos += size
+
+    def __len__(self) -> int:
+        return len(self._offsets)
+
+    def __getitem__(self, index: int) -> TraceRecord:
+        return self._record(self._offsets[index])
+
+    def __iter__(self) -> Iterator[TraceRecord]:
+        return map(self._record, self._offsets)
+
+    def _record(self, pos: int) -> TraceRecord:
+        size, tick, priority, sender_size, recipient_size = _RECORD.unpack_from(self._mmap, pos)
+        start = pos + _RECORD.size
+        sender = self._mmap[start : start + sender_size].decode()
+        start += sender_size
+        recipient = self._mmap[start : start + recipient_size].decode()
+        start += recipient_size
+        return TraceRecord(tick, priority, sender, recipient, self._mmap[start : pos + size])
+
+    def messages(self, recipient: str | None = None) -> Iterator[Message]:
+        """
+        Iterate over the recorded messages.
+
+        :param recipient: If set, only messages addressed to this recipient are returned.
+        :return: Iterator over the messages.
+        """
+        for record in self:
+            if recipient is None or record.recipient == recipient:
+                yield record.message
+
+    def replay(self, target: Callable[[Message], object], recipient: str | None = None) -> int:
+        """
+        Feed the recorded messages to a function as fast as possible, regardless of their ticks.
+
+        :param target: Function called for each message, e.g. `Server.process` or `Stack.decode`.
+        :param recipient: If set, only messages addressed to this recipient are replayed.
+        :return: Number of replayed messages.
+        """
+        count = 0
+        for msg in self.messages(recipient):
+            target(msg)
+            count += 1
+        return count
+
+    def close(self) -> None:
+        """Release the mapped file."""
+        self._mmap.close()
+
+    def __enter__(self) -> Self:
+        return self
+
+    def __exit__(
+        self,
+        exc_type: type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        self.close()
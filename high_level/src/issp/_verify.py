@@ -100,6 +100,11 @@ class CBCMAC(Verifier):
 class HMAC(Verifier):
     """HMAC message authenticator."""
 
+    @property
+    def hash_fn(self) -> Hash:
+        """The underlying hash function."""
+        return self._hash
+
     @cached_property
     def code_size(self) -> int:
         return self._hash.code_size
@@ -0,0 +1,193 @@
+from __future__ import annotations
+
+import os
+import struct
+import threading
+import time
+import zlib
+from pathlib import Path
+from typing import TYPE_CHECKING, Self
+
+if TYPE_CHECKING:
+    from collections.abc import Iterator
+    from types import TracebackType
+
+# Each record is a `_RECORD` header (payload size, CRC-32 of kind and payload, kind) followed by
+# the payload. Recovery stops at the first truncated or corrupted record, which is where a crash
+# interrupted the last write, and the file is truncated there before appending.
+
+_RECORD = struct.Struct("<IIB")
+
+_sync = getattr(os, "fdatasync", os.fsync)
+
+
+def _checksum(kind: int, payload: bytes) -> int:
+    return zlib.crc32(payload, kind)
+
+
+def _sync_directory(path: Path) -> None:
+    # Makes the creation of a file in the directory durable. Not possible, nor needed, on Windows.
+    if os.name == "posix":
+        fd = os.open(path, os.O_RDONLY)
+        try:
+            os.fsync(fd)
+        finally:
+            os.close(fd)
+
+
+class WriteAheadLog:
+    """
+    Append-only log of binary records, made durable by group commit.
+
+    .. note::
+        Records are appended to an in-memory buffer, which a writer thread writes to the file
+        and syncs to disk in batches: all the records appended while a sync is in progress,
+        or during the durability window that follows it, are committed by the next sync.
+        Callers that need durability wait for their records with `wait`. If writing or syncing
+        fails, the log stops accepting records, and `append`, `wait` and `close` raise `OSError`.
+    """
+
+    @property
+    def path(self) -> Path:
+        """Path of the log file."""
+        return self._path
+
+    @property
+    def syncs(self) -> int:
+        """Number of syncs performed so far."""
+        return self._syncs
+
+    def __init__(self, path: str | Path, window: float = 0.0) -> None:
+        """
+        Open a log, creating it if needed.
+
+        :param path: Path of the file.
+        :param window: Minimum time between two syncs, in seconds. Longer windows batch more
+                       records per sync, at the cost of a longer wait for durability.
+        """
+        self._path = Path(path)
+        self._window = window
+        self._valid_size = sum(_RECORD.size + len(p) for _, p in self.records())
+        created = not self._path.exists()
+        self._file = self._path.open("ab")
+        self._file.truncate(self._valid_size)
+        if created:
+            _sync(self._file.fileno())
+            _sync_directory(self._path.absolute().parent)
+        self._buffer = bytearray()
+        self._appended = 0
+        self._durable = 0
+        self._syncs = 0
+        self._closed = False
+        self._error: OSError | None = None
+        self._cond = threading.Condition()
+        self._writer = threading.Thread(target=self._run, daemon=True)
+        self._writer.start()
+
+    def records(self) -> Iterator[tuple[int, bytes]]:
+        """
+        Iterate over the records that were committed to the file.
+
+        :return: Iterator over the (kind, payload) records.
+        """
+        try:
+            data = self._path.read_bytes()
+        except FileNotFoundError:
+            return
+        view = memoryview(data)
+        pos = 0
+        while pos + _RECORD.size <= len(view):
+            size, checksum, kind = _RECORD.unpack_from(view, pos)
+            payload = bytes(view[pos + _RECORD.size : pos + _RECORD.size + size])
+            if len(payload) != size or _checksum(kind, payload) != checksum:
+                break
+            yield kind, payload
+            pos += _RECORD.size + size
+
+    def append(self, kind: int, payload: bytes) -> int:
+        """
+        Append a record.
+
+        :param kind: Kind of the record, between 0 and 255.
+        :param payload: Payload of the record.
+        :return: Sequence number of the record, to be passed to `wait`.
+        """
+        header = _RECORD.pack(len(payload), _checksum(kind, payload), kind)
+        with self._cond:
+            self._check()
+            if self._closed:
+                err_msg = "The log is closed"
+                raise ValueError(err_msg)
+            self._buffer += header
+            self._buffer += payload
+            self._appended += 1
+            self._cond.notify_all()
+            return self._appended
+
+    def wait(self, seq: int | None = None) -> None:
+        """
+        Wait until a record is durable.
+
+        :param seq: Sequence number of the record. If None, waits for all appended records.
+        """
+        with self._cond:
+            seq = self._appended if seq is None else seq
+            while self._durable < seq and self._error is None:
+                self._cond.wait()
+            if self._durable < seq:
+                self._check()
+
+    def _check(self) -> None:
+        # Called with the lock held.
+        if self._error is not None:
+            err_msg = f"Writing to {self._path} failed"
+            raise OSError(err_msg) from self._error
+
+    def _run(self) -> None:
+        while True:
+            with self._cond:
+                while not self._buffer and not self._closed:
+                    self._cond.wait()
+                if not self._buffer:
+                    return
+                data, self._buffer = self._buffer, bytearray()
+                seq = self._appended
+            try:
+                self._file.write(data)
+                self._file.flush()
+                _sync(self._file.fileno())
+            except OSError as e:
+                with self._cond:
+                    self._error = e
+                    self._cond.notify_all()
+                return
+            with self._cond:
+                self._durable = seq
+                self._syncs += 1
+                self._cond.notify_all()
+            if self._window > 0.0:
+                time.sleep(self._window)
+
+    def close(self) -> None:
+        """Commit all appended records and close the file."""
+        with self._cond:
+            self._closed = True
+            self._cond.notify_all()
+        self._writer.join()
+        try:
+            self._file.close()
+        except OSError as e:
+            self._error = self._error or e
+        with self._cond:
+            self._check()
+
+    def __enter__(self) -> Self:
+        return self
+
+    def __exit__(
+        self,
+        exc_type: type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        self.close()
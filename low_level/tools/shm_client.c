@@ -0,0 +1,63 @@
+// Join a Python scenario run by `issp.ProcessActor.start` as an external actor: send a message
+// through the shared memory medium, then print the first message addressed to this actor.
+//
+// Usage: tool-shm-client <segment> <slot> <name> <recipient> <message>
+//
+// The segment name and the reserved slots are logged by the Python side when it is started
+// with `external` slots.
+
+#include "issp_shm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TIMEOUT 10.0
+
+static int fail(struct IsspShm *shm, char const *what, enum IsspShmStatus status) {
+    size_t size;
+    char const *error = issp_shm_error(shm, &size);
+    if (status == ISSP_SHM_TIMEOUT) {
+        fprintf(stderr, "%s timed out\n", what);
+    } else {
+        fprintf(stderr, "%s failed: %.*s\n", what, (int)size, error);
+    }
+    issp_shm_close(shm);
+    issp_shm_detach(shm);
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 6) {
+        fprintf(stderr, "Usage: %s <segment> <slot> <name> <recipient> <message>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    struct IsspShm shm;
+    if (!issp_shm_attach(&shm, argv[1], (uint32_t)strtoul(argv[2], NULL, 10))) {
+        fprintf(stderr, "Cannot attach to segment %s, slot %s\n", argv[1], argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    char const *name = argv[3];
+    struct IsspShmMessage msg = {
+        .sender = name,
+        .sender_size = (uint16_t)strlen(name),
+        .recipient = argv[4],
+        .recipient_size = (uint16_t)strlen(argv[4]),
+        .body = (uint8_t const *)argv[5],
+        .body_size = (uint32_t)strlen(argv[5]),
+    };
+    enum IsspShmStatus status = issp_shm_write(&shm, &msg, 0, TIMEOUT);
+    if (status != ISSP_SHM_OK) return fail(&shm, "Write", status);
+    printf("[%s] Sent: %s\n", name, argv[5]);
+
+    status = issp_shm_read(&shm, name, 0, TIMEOUT, &msg);
+    if (status != ISSP_SHM_OK) return fail(&shm, "Read", status);
+    printf("[%s] Received from %.*s: %.*s\n", name, (int)msg.sender_size, msg.sender,
+           (int)msg.body_size, (char const *)msg.body);
+
+    issp_shm_close(&shm);
+    issp_shm_detach(&shm);
+    return EXIT_SUCCESS;
+}
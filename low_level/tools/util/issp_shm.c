@@ -0,0 +1,181 @@
+#include "issp_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Layout of the segment, mirroring `issp/_shm.py`. Fields are accessed through memcpy, since
+// they are not aligned, which also assumes a little-endian host.
+
+#define HEADER_SIZE 24
+#define COUNTERS_SIZE 16
+#define RING_OFFSET (HEADER_SIZE + COUNTERS_SIZE)
+#define SLOT_HEADER_SIZE 28
+#define MESSAGE_HEADER_SIZE 8
+#define NAME_MAX_SIZE 64
+
+#define OP_READ 1
+#define OP_WRITE 2
+#define OP_CLOSE 5
+
+#define FLAG_CLEAR 1
+#define FLAG_TOKEN 2
+
+static char const magic[8] = "ISSPSHM";
+
+static size_t aligned(size_t size) {
+    return (size + 7) / 8 * 8;
+}
+
+static uint8_t *slot(struct IsspShm const *shm) {
+    size_t const slots_offset = RING_OFFSET + aligned(4 * ((size_t)shm->slots + 1));
+    return shm->base + slots_offset + (SLOT_HEADER_SIZE + aligned(shm->slot_size)) * shm->index;
+}
+
+static sem_t *open_semaphore(char const *segment, char const *suffix) {
+    char name[NAME_MAX_SIZE];
+    snprintf(name, sizeof(name), "/%s-%s", segment, suffix);
+    sem_t *sem = sem_open(name, 0);
+    return sem == SEM_FAILED ? NULL : sem;
+}
+
+static void wait_semaphore(sem_t *sem) {
+    while (sem_wait(sem) == -1 && errno == EINTR) {}
+}
+
+bool issp_shm_attach(struct IsspShm *shm, char const *name, uint32_t index) {
+    memset(shm, 0, sizeof(*shm));
+    char path[NAME_MAX_SIZE];
+    snprintf(path, sizeof(path), "/%s", name);
+
+    int fd = shm_open(path, O_RDWR, 0);
+    if (fd == -1) return false;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < RING_OFFSET) {
+        close(fd);
+        return false;
+    }
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+    shm->base = base;
+    shm->size = (size_t)st.st_size;
+
+    uint32_t version;
+    memcpy(&version, shm->base + 8, sizeof(version));
+    memcpy(&shm->slots, shm->base + 12, sizeof(shm->slots));
+    memcpy(&shm->slot_size, shm->base + 16, sizeof(shm->slot_size));
+    shm->index = index;
+    if (memcmp(shm->base, magic, sizeof(magic)) != 0 || version != ISSP_SHM_VERSION ||
+        index >= shm->slots) {
+        issp_shm_detach(shm);
+        return false;
+    }
+
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "%u", index);
+    shm->lock = open_semaphore(name, "lock");
+    shm->ring = open_semaphore(name, "ring");
+    shm->done = open_semaphore(name, suffix);
+    if (!(shm->lock && shm->ring && shm->done)) {
+        issp_shm_detach(shm);
+        return false;
+    }
+    return true;
+}
+
+void issp_shm_detach(struct IsspShm *shm) {
+    if (shm->lock) sem_close(shm->lock);
+    if (shm->ring) sem_close(shm->ring);
+    if (shm->done) sem_close(shm->done);
+    if (shm->base) munmap(shm->base, shm->size);
+    memset(shm, 0, sizeof(*shm));
+}
+
+static void post(struct IsspShm *shm) {
+    uint64_t tail;
+    wait_semaphore(shm->lock);
+    memcpy(&tail, shm->base + HEADER_SIZE + 8, sizeof(tail));
+    uint8_t *entry = shm->base + RING_OFFSET + 4 * (tail % ((uint64_t)shm->slots + 1));
+    memcpy(entry, &shm->index, sizeof(shm->index));
+    tail++;
+    memcpy(shm->base + HEADER_SIZE + 8, &tail, sizeof(tail));
+    sem_post(shm->lock);
+    sem_post(shm->ring);
+}
+
+static enum IsspShmStatus request(struct IsspShm *shm, uint8_t op, uint8_t flags, int64_t value,
+                                  double timeout, uint32_t size) {
+    uint8_t *header = slot(shm);
+    header[0] = op;
+    header[1] = flags;
+    memcpy(header + 4, &value, sizeof(value));
+    memcpy(header + 12, &timeout, sizeof(timeout));
+    memcpy(header + 20, &size, sizeof(size));
+    post(shm);
+    wait_semaphore(shm->done);
+    return (enum IsspShmStatus)header[0];
+}
+
+static uint32_t response_size(struct IsspShm const *shm) {
+    uint32_t size;
+    memcpy(&size, slot(shm) + 20, sizeof(size));
+    return size;
+}
+
+enum IsspShmStatus issp_shm_write(struct IsspShm *shm, struct IsspShmMessage const *msg,
+                                  int64_t priority, double timeout) {
+    size_t const size =
+        MESSAGE_HEADER_SIZE + msg->sender_size + msg->recipient_size + (size_t)msg->body_size;
+    if (size > shm->slot_size) return ISSP_SHM_ERROR;
+
+    uint8_t *data = slot(shm) + SLOT_HEADER_SIZE;
+    memcpy(data, &msg->sender_size, 2);
+    memcpy(data + 2, &msg->recipient_size, 2);
+    memcpy(data + 4, &msg->body_size, 4);
+    data += MESSAGE_HEADER_SIZE;
+    memcpy(data, msg->sender, msg->sender_size);
+    data += msg->sender_size;
+    memcpy(data, msg->recipient, msg->recipient_size);
+    data += msg->recipient_size;
+    memcpy(data, msg->body, msg->body_size);
+    return request(shm, OP_WRITE, 0, priority, timeout, (uint32_t)size);
+}
+
+enum IsspShmStatus issp_shm_read(struct IsspShm *shm, char const *recipient, int64_t priority,
+                                 double timeout, struct IsspShmMessage *msg) {
+    uint8_t flags = FLAG_CLEAR;
+    size_t size = 0;
+    if (recipient) {
+        flags |= FLAG_TOKEN;
+        size = strlen(recipient);
+        if (size > shm->slot_size) return ISSP_SHM_ERROR;
+        memcpy(slot(shm) + SLOT_HEADER_SIZE, recipient, size);
+    }
+
+    enum IsspShmStatus status = request(shm, OP_READ, flags, priority, timeout, (uint32_t)size);
+    if (status != ISSP_SHM_OK) return status;
+
+    uint8_t const *data = slot(shm) + SLOT_HEADER_SIZE;
+    memcpy(&msg->sender_size, data, 2);
+    memcpy(&msg->recipient_size, data + 2, 2);
+    memcpy(&msg->body_size, data + 4, 4);
+    data += MESSAGE_HEADER_SIZE;
+    msg->sender = (char const *)data;
+    msg->recipient = msg->sender + msg->sender_size;
+    msg->body = (uint8_t const *)msg->recipient + msg->recipient_size;
+    return status;
+}
+
+enum IsspShmStatus issp_shm_close(struct IsspShm *shm) {
+    return request(shm, OP_CLOSE, 0, 0, 0.0, 0);
+}
+
+char const *issp_shm_error(struct IsspShm const *shm, size_t *size) {
+    *size = response_size(shm);
+    return (char const *)slot(shm) + SLOT_HEADER_SIZE;
+}
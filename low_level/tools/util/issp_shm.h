@@ -0,0 +1,113 @@
+#ifndef ISSP_SHM_H
+#define ISSP_SHM_H
+
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Client of the shared memory medium hosted by `issp.ProcessActor.start` (see `issp/_shm.py`).
+//
+// The segment is named by the Python side, and each external process is given the index of
+// one of its slots. Requests are written to the slot, posted to the ring, and answered by
+// the medium in the same slot. All integers in the segment are little-endian.
+
+/// Layout version of the segment supported by this client.
+#define ISSP_SHM_VERSION 1
+
+/// Status of a request, as written by the medium.
+enum IsspShmStatus {
+    ISSP_SHM_OK = 0,
+    ISSP_SHM_TIMEOUT = 1,
+    ISSP_SHM_ERROR = 2,
+};
+
+/// Attached shared memory segment.
+struct IsspShm {
+    uint8_t *base;
+    size_t size;
+    uint32_t slots;
+    uint32_t slot_size;
+    uint32_t index;
+    sem_t *lock;
+    sem_t *ring;
+    sem_t *done;
+};
+
+/// Message read from the medium. Its fields point into the slot, and are only valid
+/// until the next request.
+struct IsspShmMessage {
+    char const *sender;
+    uint16_t sender_size;
+    char const *recipient;
+    uint16_t recipient_size;
+    uint8_t const *body;
+    uint32_t body_size;
+};
+
+/**
+ * Attach to a segment.
+ *
+ * @param shm The segment.
+ * @param name Name of the segment, as logged by the Python side.
+ * @param index Index of the slot reserved for this process.
+ *
+ * @return True on success, false otherwise.
+ */
+bool issp_shm_attach(struct IsspShm *shm, char const *name, uint32_t index);
+
+/**
+ * Detach from a segment, without closing the medium.
+ *
+ * @param shm The segment.
+ */
+void issp_shm_detach(struct IsspShm *shm);
+
+/**
+ * Write a message to the medium.
+ *
+ * @param shm The segment.
+ * @param msg The message.
+ * @param priority Priority of the write.
+ * @param timeout Timeout in seconds, or NAN to wait indefinitely.
+ *
+ * @return Status of the request.
+ */
+enum IsspShmStatus issp_shm_write(struct IsspShm *shm, struct IsspShmMessage const *msg,
+                                  int64_t priority, double timeout);
+
+/**
+ * Read the next message addressed to a recipient.
+ *
+ * @param shm The segment.
+ * @param recipient The recipient, or NULL to read any message.
+ * @param priority Priority of the read.
+ * @param timeout Timeout in seconds, or NAN to wait indefinitely.
+ * @param msg The message read, if the request succeeds.
+ *
+ * @return Status of the request.
+ */
+enum IsspShmStatus issp_shm_read(struct IsspShm *shm, char const *recipient, int64_t priority,
+                                 double timeout, struct IsspShmMessage *msg);
+
+/**
+ * Close the medium of this process. The Python side waits for every external process
+ * to do so before returning.
+ *
+ * @param shm The segment.
+ *
+ * @return Status of the request.
+ */
+enum IsspShmStatus issp_shm_close(struct IsspShm *shm);
+
+/**
+ * Get the error message written by the medium for a failed request.
+ *
+ * @param shm The segment.
+ * @param size Size of the message.
+ *
+ * @return The message, which is not null-terminated.
+ */
+char const *issp_shm_error(struct IsspShm const *shm, size_t *size);
+
+#endif // ISSP_SHM_H